@@ -8,32 +8,82 @@ LIBS += -ldl -lm -lpthread
 
 SOURCES += src/main.cpp \
            src/api/HifiClient.cpp \
+           src/api/ResponseParser.cpp \
+           src/api/RetryPolicy.cpp \
+           src/model/Track.cpp \
            src/player/AudioPlayer.cpp \
+           src/player/StreamFetcher.cpp \
            src/ui/MainWindow.cpp \
            src/ui/TrackItemWidget.cpp \
            src/ui/FavoriteCard.cpp \
            src/ui/AlbumCard.cpp \
            src/db/DatabaseManager.cpp \
+           src/db/StorageManager.cpp \
+           src/net/BandwidthGovernor.cpp \
            src/net/DownloadManager.cpp \
+           src/net/NetworkAccess.cpp \
+           src/net/OfflineSync.cpp \
+           src/net/TransferScheduler.cpp \
            src/ui/CreateAlbumDialog.cpp \
            src/ui/ArtistProfilePage.cpp
 
 HEADERS += src/api/HifiClient.hpp \
+           src/api/ResponseParser.hpp \
+           src/api/RetryPolicy.hpp \
+           src/model/Track.hpp \
            src/player/AudioPlayer.hpp \
+           src/player/StreamFetcher.hpp \
            src/ui/MainWindow.hpp \
            src/ui/TrackItemWidget.hpp \
            src/ui/FavoriteCard.hpp \
            src/ui/AlbumCard.hpp \
            src/db/DatabaseManager.hpp \
+           src/db/StorageManager.hpp \
+           src/net/BandwidthGovernor.hpp \
            src/net/DownloadManager.hpp \
+           src/net/NetworkAccess.hpp \
+           src/net/OfflineSync.hpp \
+           src/net/TransferScheduler.hpp \
            src/ui/CreateAlbumDialog.hpp \
            src/ui/ArtistProfilePage.hpp
 
 # Test target
 test {
     TARGET = api_test
-    SOURCES = src/api_test.cpp src/api/HifiClient.cpp
-    HEADERS = src/api/HifiClient.hpp
+    SOURCES = src/api_test.cpp src/api/HifiClient.cpp src/api/ResponseParser.cpp \
+              src/api/RetryPolicy.cpp src/model/Track.cpp \
+              src/net/BandwidthGovernor.cpp src/net/NetworkAccess.cpp
+    HEADERS = src/api/HifiClient.hpp src/api/ResponseParser.hpp \
+              src/api/RetryPolicy.hpp src/model/Track.hpp \
+              src/net/BandwidthGovernor.hpp src/net/NetworkAccess.hpp
     QT -= widgets
 }
 
+# Schema migration and query plan checks against a scratch database
+db_test {
+    TARGET = db_test
+    SOURCES = src/db_test.cpp src/db/DatabaseManager.cpp \
+              src/api/ResponseParser.cpp src/model/Track.cpp
+    HEADERS = src/db/DatabaseManager.hpp src/api/ResponseParser.hpp \
+              src/model/Track.hpp
+    QT -= widgets network
+}
+
+# Parser benchmark over recorded mirror responses
+bench {
+    TARGET = parse_bench
+    SOURCES = src/parse_bench.cpp src/api/ResponseParser.cpp src/model/Track.cpp
+    HEADERS = src/api/ResponseParser.hpp src/model/Track.hpp
+    DEFINES += BENCH_DATA_DIR=\\\"$$PWD/bench\\\"
+    QT -= widgets network sql
+}
+
+# Per-operation latency of the original queries against DatabaseManager
+db_bench {
+    TARGET = db_bench
+    SOURCES = src/db_bench.cpp src/db/DatabaseManager.cpp \
+              src/api/ResponseParser.cpp src/model/Track.cpp
+    HEADERS = src/db/DatabaseManager.hpp src/api/ResponseParser.hpp \
+              src/model/Track.hpp
+    QT -= widgets network
+}
@@ -1,9 +1,22 @@
 #include "HifiClient.hpp"
+#include "ResponseParser.hpp"
+#include "../net/NetworkAccess.hpp"
 #include <QDebug>
+#include <QTimer>
+#include <utility>
+
+// Stats are published at most this often
+static const int statsIntervalMs = 1000;
 
 HifiClient::HifiClient(QObject *parent)
     : QObject(parent), currentEndpointIndex(0) {
-  manager = new QNetworkAccessManager(this);
+  manager = NetworkAccess::instance().manager();
+  policy = new RetryPolicy(this);
+  statsTimer = new QTimer(this);
+  statsTimer->setSingleShot(true);
+  statsTimer->setInterval(statsIntervalMs);
+  connect(statsTimer, &QTimer::timeout, this,
+          [this]() { emit statsChanged(stats, policy->mirrorStatus()); });
 
   // Multiple API endpoints from tidal-ui config for redundancy
   apiEndpoints << "https://wolf.qqdl.site"
@@ -30,99 +43,234 @@ void HifiClient::rotateEndpoint() {
   qDebug() << "Rotated to endpoint:" << getCurrentBaseUrl();
 }
 
-void HifiClient::searchTracks(const QString &query) {
+QStringList HifiClient::acquireEndpoints(int count) {
+  QStringList picked;
+  for (int i = 0; i < apiEndpoints.size() && picked.size() < count; ++i) {
+    const QString &mirror =
+        apiEndpoints[(currentEndpointIndex + i) % apiEndpoints.size()];
+    if (policy->tryAcquire(mirror))
+      picked.append(mirror);
+  }
+  publishStats();
+  return picked;
+}
+
+QString HifiClient::acquireEndpoint() { return acquireEndpoints(1).value(0); }
+
+void HifiClient::preconnect(int count) {
+  if (postToOwnThread([this, count]() { preconnect(count); }))
+    return;
+
+  // Warm the mirrors the next requests will go to, skipping open breakers
+  QSet<QString> unavailable;
+  for (const RetryPolicy::MirrorStatus &status : policy->mirrorStatus()) {
+    if (status.state == RetryPolicy::Open)
+      unavailable.insert(status.mirror);
+  }
+
+  QStringList targets;
+  for (int i = 0; i < apiEndpoints.size() && targets.size() < count; ++i) {
+    const QString &mirror =
+        apiEndpoints[(currentEndpointIndex + i) % apiEndpoints.size()];
+    if (!unavailable.contains(mirror))
+      targets.append(mirror);
+  }
+  NetworkAccess::instance().preconnect(targets);
+}
+
+void HifiClient::recordOutcome(QNetworkReply *reply) {
+  QString mirror =
+      reply->request().url().toString(QUrl::RemovePath | QUrl::RemoveQuery);
+  int statusCode =
+      reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+  if (reply->error() == QNetworkReply::OperationCanceledError) {
+    policy->recordCancelled(mirror);
+  } else if (statusCode == 429) {
+    policy->recordRateLimited(mirror);
+  } else if (reply->error() == QNetworkReply::NoError ||
+             (statusCode >= 400 && statusCode < 500)) {
+    policy->recordSuccess(mirror); // The mirror answered, if unhelpfully
+  } else {
+    policy->recordFailure(mirror);
+  }
+  publishStats();
+}
+
+void HifiClient::publishStats() {
+  if (!statsTimer->isActive())
+    statsTimer->start();
+}
+
+bool HifiClient::retryLater(int attempt, const std::function<void()> &retry) {
+  publishStats();
+  if (attempt + 1 >= policy->maxAttempts()) {
+    stats.abandoned++;
+    return false;
+  }
+  stats.retried++;
+  int delay = policy->backoffDelay(attempt);
+  qDebug() << "HifiClient: Retry" << attempt + 1 << "in" << delay << "ms";
+  QTimer::singleShot(delay, this, retry);
+  return true;
+}
+
+bool HifiClient::joinInFlight(const QString &key) {
+  if (inFlight.contains(key)) {
+    stats.coalesced++;
+    qDebug() << "HifiClient: Coalesced" << key << "(" << stats.coalesced
+             << "coalesced," << stats.issued << "issued)";
+    return true;
+  }
+  inFlight.insert(key);
+  stats.issued++;
+  return false;
+}
+
+void HifiClient::leaveInFlight(const QString &key) { inFlight.remove(key); }
+
+void HifiClient::searchTracks(const QString &query, int offset, int limit) {
+  auto repost = [this, query, offset, limit]() {
+    searchTracks(query, offset, limit);
+  };
+  if (postToOwnThread(repost))
+    return;
+
+  // Same page still in flight: its result will reach this caller too
+  if (!pendingSearchReplies.isEmpty() && query == lastQuery &&
+      offset == lastSearchOffset) {
+    stats.coalesced++;
+    qDebug() << "HifiClient: Coalesced search" << query << offset;
+    return;
+  }
+
   lastQuery = query;
-  lastRequestType = RequestType::Search;
+  lastSearchOffset = offset;
+  stats.issued++;
 
   cancelPendingSearch();
+  searchTimer.start();
 
-  // Try top 3 endpoints in parallel
-  int count = 0;
-  for (int i = 0; i < apiEndpoints.size() && count < 3; ++i) {
-    int idx = (currentEndpointIndex + i) % apiEndpoints.size();
-    QString baseUrl = apiEndpoints[idx];
-
+  // Try top 3 admitted endpoints in parallel
+  const QStringList endpoints = acquireEndpoints(3);
+  if (endpoints.isEmpty()) {
+    qDebug() << "HifiClient: No mirror available for search";
+    emit searchResults(query, offset, offset, QList<Track>());
+    return;
+  }
+  for (const QString &baseUrl : endpoints) {
     QUrl url(baseUrl + "/search/");
     QUrlQuery q;
     q.addQueryItem("s", query);
+    q.addQueryItem("limit", QString::number(limit));
+    q.addQueryItem("offset", QString::number(offset));
     url.setQuery(q);
 
-    QNetworkRequest request(url);
+    QNetworkRequest request = NetworkAccess::instance().request(url);
     QNetworkReply *reply = manager->get(request);
     pendingSearchReplies.append(reply);
 
     connect(reply, &QNetworkReply::finished, this,
             &HifiClient::onSearchFinished);
-    count++;
   }
 }
 
 void HifiClient::getTrackStream(int trackId) {
-  lastTrackId = trackId;
-  lastRequestType = RequestType::Track;
-
-  cancelPendingTrack();
+  if (postToOwnThread([this, trackId]() { getTrackStream(trackId); }))
+    return;
 
-  // Try top 3 endpoints in parallel
-  int count = 0;
-  for (int i = 0; i < apiEndpoints.size() && count < 3; ++i) {
-    int idx = (currentEndpointIndex + i) % apiEndpoints.size();
-    QString baseUrl = apiEndpoints[idx];
+  // Playback and favorite downloads may ask for the same stream; share it
+  if (pendingTrackReplies.contains(trackId)) {
+    stats.coalesced++;
+    qDebug() << "HifiClient: Coalesced track stream" << trackId;
+    return;
+  }
+  stats.issued++;
 
+  // Try top 3 admitted endpoints in parallel
+  const QStringList endpoints = acquireEndpoints(3);
+  if (endpoints.isEmpty()) {
+    emit errorOccurred("Track stream failed: no mirror available");
+    emit trackStreamFailed(trackId);
+    return;
+  }
+  for (const QString &baseUrl : endpoints) {
     QUrl url(baseUrl + "/track/");
     QUrlQuery q;
     q.addQueryItem("id", QString::number(trackId));
     q.addQueryItem("quality", "LOSSLESS");
     url.setQuery(q);
 
-    QNetworkRequest request(url);
+    QNetworkRequest request = NetworkAccess::instance().request(url);
     QNetworkReply *reply = manager->get(request);
-    pendingTrackReplies.append(reply);
+    reply->setProperty("trackId", trackId);
+    pendingTrackReplies[trackId].append(reply);
 
     connect(reply, &QNetworkReply::finished, this,
             &HifiClient::onTrackStreamFinished);
-    count++;
   }
 }
 
 void HifiClient::getAlbum(int albumId) {
-  lastAlbumId = albumId;
-  lastRequestType = RequestType::Album;
+  if (postToOwnThread([this, albumId]() { getAlbum(albumId); }))
+    return;
+  if (joinInFlight(QString("album:%1").arg(albumId)))
+    return;
+  requestAlbum(albumId);
+}
+
+void HifiClient::requestAlbum(int albumId, int attempt) {
+  QString baseUrl = acquireEndpoint();
+  if (baseUrl.isEmpty()) {
+    retryAlbum(albumId, attempt);
+    return;
+  }
 
-  QUrl url(getCurrentBaseUrl() + "/album/");
+  QUrl url(baseUrl + "/album/");
   QUrlQuery q;
   q.addQueryItem("id", QString::number(albumId));
   url.setQuery(q);
 
-  QNetworkRequest request(url);
+  QNetworkRequest request = NetworkAccess::instance().request(url);
   QNetworkReply *reply = manager->get(request);
+  reply->setProperty("albumId", albumId);
+  reply->setProperty("attempt", attempt);
   connect(reply, &QNetworkReply::finished, this, &HifiClient::onAlbumFinished);
 }
 
+void HifiClient::retryAlbum(int albumId, int attempt) {
+  auto retry = [this, albumId, attempt]() {
+    requestAlbum(albumId, attempt + 1);
+  };
+  if (retryLater(attempt, retry))
+    return;
+  leaveInFlight(QString("album:%1").arg(albumId));
+  emit errorOccurred("Album could not be loaded from any mirror");
+  emit albumFailed(albumId);
+}
+
 void HifiClient::onSearchFinished() {
   QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
   if (!reply)
     return;
+  recordOutcome(reply);
+  if (!pendingSearchReplies.contains(reply))
+    return;
 
   if (reply->error() == QNetworkReply::NoError) {
     QByteArray data = reply->readAll();
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    QJsonObject root = doc.object();
-
-    QJsonArray tracks;
-    if (root.contains("tracks")) {
-      QJsonObject tracksObj = root["tracks"].toObject();
-      if (tracksObj.contains("items")) {
-        tracks = tracksObj["items"].toArray();
-      }
-    } else if (root.contains("items")) {
-      tracks = root["items"].toArray();
-    }
+
+    // Pull only the fields we display straight out of the reply buffer
+    int total = -1;
+    QList<Track> tracks = ResponseParser::parseTracks(data, &total);
+    if (total < 0) // Mirror does not page: this is everything
+      total = lastSearchOffset + tracks.size();
 
     // If we got valid results, cancel other pending requests and emit
     if (!tracks.isEmpty()) {
+      recordSearchLatency();
       cancelPendingSearch();
-      emit searchResults(tracks);
+      emit searchResults(lastQuery, lastSearchOffset, total, tracks);
     } else {
       // Empty results, treat as error/next? No, just wait for others or emit
       // empty if all done. For now, if one returns empty, maybe others will
@@ -132,7 +280,9 @@ void HifiClient::onSearchFinished() {
       reply->deleteLater();
 
       if (pendingSearchReplies.isEmpty()) {
-        emit searchResults(QJsonArray());
+        recordSearchLatency();
+        emit searchResults(lastQuery, lastSearchOffset, lastSearchOffset,
+                           QList<Track>());
       }
     }
   } else {
@@ -145,188 +295,262 @@ void HifiClient::onSearchFinished() {
       rotateEndpoint(); // Move to next set?
       // emit errorOccurred("All search endpoints failed");
       // Or just emit empty
-      emit searchResults(QJsonArray());
+      emit searchResults(lastQuery, lastSearchOffset, lastSearchOffset,
+                         QList<Track>());
     }
   }
 }
 
+void HifiClient::recordSearchLatency() {
+  // Exponentially weighted, so one slow mirror does not swing the estimate
+  double sample = searchTimer.elapsed();
+  searchLatencyMs =
+      searchLatencyMs == 0 ? sample : 0.8 * searchLatencyMs + 0.2 * sample;
+  searchLatencyEstimate = int(searchLatencyMs);
+}
+
 void HifiClient::cancelPendingSearch() {
-  for (QNetworkReply *reply : pendingSearchReplies) {
+  if (postToOwnThread([this]() { cancelPendingSearch(); }))
+    return;
+
+  // Detach first: abort() re-enters onSearchFinished for each reply
+  const QList<QNetworkReply *> replies = std::exchange(pendingSearchReplies, {});
+  for (QNetworkReply *reply : replies) {
     if (reply->isRunning()) {
       reply->abort();
     }
     reply->deleteLater();
   }
-  pendingSearchReplies.clear();
 }
 
 void HifiClient::onTrackStreamFinished() {
   QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
   if (!reply)
     return;
+  recordOutcome(reply);
+
+  int trackId = reply->property("trackId").toInt();
+  auto it = pendingTrackReplies.find(trackId);
+  if (it == pendingTrackReplies.end() || !it->contains(reply))
+    return; // Aborted because a sibling mirror answered first
+  QList<QNetworkReply *> &pending = *it;
 
   if (reply->error() == QNetworkReply::NoError) {
     QByteArray data = reply->readAll();
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-
-    QString streamUrl;
-
-    // Handle array response
-    if (doc.isArray()) {
-      QJsonArray arr = doc.array();
-      for (const auto &val : arr) {
-        QJsonObject obj = val.toObject();
-        if (obj.contains("manifest")) {
-          QString manifest = obj["manifest"].toString();
-          QByteArray decoded = QByteArray::fromBase64(manifest.toUtf8());
-          QJsonDocument manifestDoc = QJsonDocument::fromJson(decoded);
-          if (manifestDoc.object().contains("urls")) {
-            QJsonArray urls = manifestDoc.object()["urls"].toArray();
-            if (!urls.isEmpty()) {
-              streamUrl = urls[0].toString();
-            }
-          }
-        }
-      }
-    } else {
-      QJsonObject root = doc.object();
-      if (root.contains("manifest")) {
-        QString manifest = root["manifest"].toString();
-        QByteArray decoded = QByteArray::fromBase64(manifest.toUtf8());
-        QJsonDocument manifestDoc = QJsonDocument::fromJson(decoded);
-        if (manifestDoc.object().contains("urls")) {
-          QJsonArray urls = manifestDoc.object()["urls"].toArray();
-          if (!urls.isEmpty()) {
-            streamUrl = urls[0].toString();
-          }
-        }
-      }
-    }
+    QString streamUrl = ResponseParser::parseStreamUrl(data);
 
     if (!streamUrl.isEmpty()) {
-      cancelPendingTrack();
-      emit trackStreamUrl(streamUrl);
+      cancelPendingTrack(trackId);
+      emit trackStreamUrl(trackId, streamUrl);
     } else {
       // Failed to parse stream URL, treat as error for this reply
-      pendingTrackReplies.removeAll(reply);
+      pending.removeAll(reply);
       reply->deleteLater();
 
-      if (pendingTrackReplies.isEmpty()) {
+      if (pending.isEmpty()) {
+        pendingTrackReplies.remove(trackId);
         emit errorOccurred("Could not find stream URL in response");
+        emit trackStreamFailed(trackId);
       }
     }
 
   } else {
-    pendingTrackReplies.removeAll(reply);
+    pending.removeAll(reply);
     reply->deleteLater();
 
-    if (pendingTrackReplies.isEmpty()) {
+    if (pending.isEmpty()) {
+      pendingTrackReplies.remove(trackId);
       QString errorMsg = reply->errorString();
       qDebug() << "Track stream failed on all tried endpoints:" << errorMsg;
       rotateEndpoint();
       // Retry? Or just fail. Let's fail to avoid infinite loops if all down.
-      // getTrackStream(lastTrackId);
       emit errorOccurred("Track stream failed: " + errorMsg);
+      emit trackStreamFailed(trackId);
     }
   }
 }
 
-void HifiClient::cancelPendingTrack() {
-  for (QNetworkReply *reply : pendingTrackReplies) {
+void HifiClient::cancelPendingTrack(int trackId) {
+  const QList<QNetworkReply *> replies = pendingTrackReplies.take(trackId);
+  for (QNetworkReply *reply : replies) {
     if (reply->isRunning()) {
       reply->abort();
     }
     reply->deleteLater();
   }
-  pendingTrackReplies.clear();
 }
 
 void HifiClient::onAlbumFinished() {
   QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
   if (!reply)
     return;
+  recordOutcome(reply);
+
+  int albumId = reply->property("albumId").toInt();
+  int attempt = reply->property("attempt").toInt();
 
   if (reply->error() == QNetworkReply::NoError) {
     QByteArray data = reply->readAll();
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    emit albumLoaded(doc.object());
+    Album album;
+    QList<Track> tracks;
+    ResponseParser::parseAlbum(data, album, tracks);
+    album.id = albumId; // Not part of the response body
+
+    // Tracks listed under an album may omit their own album block
+    for (Track &track : tracks) {
+      if (track.cover().isEmpty())
+        track.setAlbum(album.title, album.cover);
+    }
+
+    leaveInFlight(QString("album:%1").arg(albumId));
+    emit albumLoaded(album, tracks);
   } else {
     QString errorMsg = reply->errorString();
-    qDebug() << "Album failed on" << getCurrentBaseUrl() << ":" << errorMsg;
+    qDebug() << "Album failed on" << reply->url().host() << ":" << errorMsg;
     rotateEndpoint();
-    getAlbum(lastAlbumId);
+    retryAlbum(albumId, attempt);
   }
   reply->deleteLater();
 }
 
 void HifiClient::getArtist(int artistId) {
-  lastArtistId = artistId;
-  lastRequestType = RequestType::Artist;
+  if (postToOwnThread([this, artistId]() { getArtist(artistId); }))
+    return;
+  if (joinInFlight(QString("artist:%1").arg(artistId)))
+    return;
+  requestArtist(artistId);
+}
+
+void HifiClient::requestArtist(int artistId, int attempt) {
+  QString baseUrl = acquireEndpoint();
+  if (baseUrl.isEmpty()) {
+    retryArtist(artistId, attempt);
+    return;
+  }
 
-  QUrl url(getCurrentBaseUrl() + "/artist/");
+  QUrl url(baseUrl + "/artist/");
   QUrlQuery q;
   q.addQueryItem("id", QString::number(artistId));
   url.setQuery(q);
 
-  QNetworkRequest request(url);
+  QNetworkRequest request = NetworkAccess::instance().request(url);
   QNetworkReply *reply = manager->get(request);
+  reply->setProperty("artistId", artistId);
+  reply->setProperty("attempt", attempt);
   connect(reply, &QNetworkReply::finished, this, &HifiClient::onArtistFinished);
 }
 
+void HifiClient::retryArtist(int artistId, int attempt) {
+  auto retry = [this, artistId, attempt]() {
+    requestArtist(artistId, attempt + 1);
+  };
+  if (retryLater(attempt, retry))
+    return;
+  leaveInFlight(QString("artist:%1").arg(artistId));
+  emit artistLoaded(Artist()); // Empty signals failure
+}
+
 void HifiClient::getArtistTopTracks(int artistId) {
-  lastArtistId = artistId;
-  lastRequestType = RequestType::ArtistTopTracks;
+  if (postToOwnThread([this, artistId]() { getArtistTopTracks(artistId); }))
+    return;
+  if (joinInFlight(QString("artist-top:%1").arg(artistId)))
+    return;
+  requestArtistTopTracks(artistId);
+}
+
+void HifiClient::requestArtistTopTracks(int artistId, int attempt) {
+  QString baseUrl = acquireEndpoint();
+  if (baseUrl.isEmpty()) {
+    retryArtistTopTracks(artistId, attempt);
+    return;
+  }
 
-  QUrl url(getCurrentBaseUrl() + QString("/artist/%1/toptracks").arg(artistId));
+  QUrl url(baseUrl + QString("/artist/%1/toptracks").arg(artistId));
 
-  QNetworkRequest request(url);
+  QNetworkRequest request = NetworkAccess::instance().request(url);
   QNetworkReply *reply = manager->get(request);
+  reply->setProperty("artistId", artistId);
+  reply->setProperty("attempt", attempt);
   connect(reply, &QNetworkReply::finished, this,
           &HifiClient::onArtistTopTracksFinished);
 }
 
+void HifiClient::retryArtistTopTracks(int artistId, int attempt) {
+  auto retry = [this, artistId, attempt]() {
+    requestArtistTopTracks(artistId, attempt + 1);
+  };
+  if (retryLater(attempt, retry))
+    return;
+  leaveInFlight(QString("artist-top:%1").arg(artistId));
+  emit artistTopTracksLoaded(QList<Track>());
+}
+
 void HifiClient::getArtistAlbums(int artistId) {
-  lastArtistId = artistId;
-  lastRequestType = RequestType::ArtistAlbums;
+  if (postToOwnThread([this, artistId]() { getArtistAlbums(artistId); }))
+    return;
+  if (joinInFlight(QString("artist-albums:%1").arg(artistId)))
+    return;
+  requestArtistAlbums(artistId);
+}
+
+void HifiClient::requestArtistAlbums(int artistId, int attempt) {
+  QString baseUrl = acquireEndpoint();
+  if (baseUrl.isEmpty()) {
+    retryArtistAlbums(artistId, attempt);
+    return;
+  }
 
-  QUrl url(getCurrentBaseUrl() + QString("/artist/%1/albums").arg(artistId));
+  QUrl url(baseUrl + QString("/artist/%1/albums").arg(artistId));
 
-  QNetworkRequest request(url);
+  QNetworkRequest request = NetworkAccess::instance().request(url);
   QNetworkReply *reply = manager->get(request);
+  reply->setProperty("artistId", artistId);
+  reply->setProperty("attempt", attempt);
   connect(reply, &QNetworkReply::finished, this,
           &HifiClient::onArtistAlbumsFinished);
 }
 
+void HifiClient::retryArtistAlbums(int artistId, int attempt) {
+  auto retry = [this, artistId, attempt]() {
+    requestArtistAlbums(artistId, attempt + 1);
+  };
+  if (retryLater(attempt, retry))
+    return;
+  leaveInFlight(QString("artist-albums:%1").arg(artistId));
+  emit artistAlbumsLoaded(QList<Album>());
+}
+
 void HifiClient::onArtistFinished() {
   QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
   if (!reply)
     return;
+  recordOutcome(reply);
+
+  int artistId = reply->property("artistId").toInt();
+  int attempt = reply->property("attempt").toInt();
+  QString key = QString("artist:%1").arg(artistId);
 
   if (reply->error() == QNetworkReply::NoError) {
     QByteArray data = reply->readAll();
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    QJsonObject obj = doc.object();
-    qDebug() << "HifiClient: Artist response keys:" << obj.keys();
-    if (obj.contains("tracks"))
-      qDebug() << "HifiClient: Response contains 'tracks'";
-    if (obj.contains("albums"))
-      qDebug() << "HifiClient: Response contains 'albums'";
-
-    emit artistLoaded(obj);
+    Artist artist = ResponseParser::parseArtist(data);
+    qDebug() << "HifiClient: Artist loaded:" << artist.name;
+
+    leaveInFlight(key);
+    emit artistLoaded(artist);
   } else {
     int statusCode =
         reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
     QString errorMsg = reply->errorString();
-    qDebug() << "Artist failed on" << getCurrentBaseUrl() << ":" << errorMsg
+    qDebug() << "Artist failed on" << reply->url().host() << ":" << errorMsg
              << "Code:" << statusCode;
 
     if (statusCode == 404) {
       qDebug() << "Artist not found (404), stopping retries.";
-      emit artistLoaded(
-          QJsonObject()); // Emit empty to signal failure/not found
+      leaveInFlight(key);
+      emit artistLoaded(Artist()); // Emit empty to signal failure/not found
     } else {
       rotateEndpoint();
-      getArtist(lastArtistId);
+      retryArtist(artistId, attempt);
     }
   }
   reply->deleteLater();
@@ -336,32 +560,32 @@ void HifiClient::onArtistTopTracksFinished() {
   QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
   if (!reply)
     return;
+  recordOutcome(reply);
+
+  int artistId = reply->property("artistId").toInt();
+  int attempt = reply->property("attempt").toInt();
+  QString key = QString("artist-top:%1").arg(artistId);
 
   if (reply->error() == QNetworkReply::NoError) {
     QByteArray data = reply->readAll();
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-
-    QJsonArray tracks;
-    if (doc.isArray()) {
-      tracks = doc.array();
-    } else if (doc.object().contains("items")) {
-      tracks = doc.object()["items"].toArray();
-    }
+    QList<Track> tracks = ResponseParser::parseTracks(data);
 
+    leaveInFlight(key);
     emit artistTopTracksLoaded(tracks);
   } else {
     int statusCode =
         reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
     QString errorMsg = reply->errorString();
-    qDebug() << "Artist top tracks failed on" << getCurrentBaseUrl() << ":"
+    qDebug() << "Artist top tracks failed on" << reply->url().host() << ":"
              << errorMsg << "Code:" << statusCode;
 
     if (statusCode == 404) {
       qDebug() << "Artist top tracks not found (404), stopping retries.";
-      emit artistTopTracksLoaded(QJsonArray());
+      leaveInFlight(key);
+      emit artistTopTracksLoaded(QList<Track>());
     } else {
       rotateEndpoint();
-      getArtistTopTracks(lastArtistId);
+      retryArtistTopTracks(artistId, attempt);
     }
   }
   reply->deleteLater();
@@ -371,32 +595,32 @@ void HifiClient::onArtistAlbumsFinished() {
   QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
   if (!reply)
     return;
+  recordOutcome(reply);
+
+  int artistId = reply->property("artistId").toInt();
+  int attempt = reply->property("attempt").toInt();
+  QString key = QString("artist-albums:%1").arg(artistId);
 
   if (reply->error() == QNetworkReply::NoError) {
     QByteArray data = reply->readAll();
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-
-    QJsonArray albums;
-    if (doc.isArray()) {
-      albums = doc.array();
-    } else if (doc.object().contains("items")) {
-      albums = doc.object()["items"].toArray();
-    }
+    QList<Album> albums = ResponseParser::parseAlbums(data);
 
+    leaveInFlight(key);
     emit artistAlbumsLoaded(albums);
   } else {
     int statusCode =
         reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
     QString errorMsg = reply->errorString();
-    qDebug() << "Artist albums failed on" << getCurrentBaseUrl() << ":"
+    qDebug() << "Artist albums failed on" << reply->url().host() << ":"
              << errorMsg << "Code:" << statusCode;
 
     if (statusCode == 404) {
       qDebug() << "Artist albums not found (404), stopping retries.";
-      emit artistAlbumsLoaded(QJsonArray());
+      leaveInFlight(key);
+      emit artistAlbumsLoaded(QList<Album>());
     } else {
       rotateEndpoint();
-      getArtistAlbums(lastArtistId);
+      retryArtistAlbums(artistId, attempt);
     }
   }
   reply->deleteLater();
@@ -1,36 +1,74 @@
 #pragma once
 
-#include <QJsonArray>
-#include <QJsonDocument>
-#include <QJsonObject>
+#include "../model/Track.hpp"
+#include "RetryPolicy.hpp"
+#include <QElapsedTimer>
+#include <QHash>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QObject>
+#include <QSet>
 #include <QStringList>
+#include <QThread>
+#include <QTimer>
 #include <QUrl>
 #include <QUrlQuery>
 
+#include <atomic>
+#include <functional>
+
+// Lives on NetworkAccess's I/O thread. Public requests may be made from any
+// thread and are re-posted to the client's own; results arrive as signals.
 class HifiClient : public QObject {
   Q_OBJECT
 
 public:
   explicit HifiClient(QObject *parent = nullptr);
 
-  void searchTracks(const QString &query);
+  // One page of results; later pages are requested with a growing offset
+  void searchTracks(const QString &query, int offset = 0, int limit = 25);
+  // Drop the search in flight; its results will not be emitted
+  void cancelPendingSearch();
+  // Smoothed time from issuing a search to its first usable reply, in ms.
+  // Zero until a search has completed.
+  int searchLatency() const { return searchLatencyEstimate; }
   void getTrackStream(int trackId);
   void getAlbum(int albumId);
   void getArtist(int artistId);
   void getArtistTopTracks(int artistId);
   void getArtistAlbums(int artistId);
 
+  // Opens connections to the mirrors the next requests will use
+  void preconnect(int count = 3);
+
+  // Counters for the single-flight layer: every public request either issues
+  // a network request or attaches to one already in flight.
+  struct RequestStats {
+    quint64 issued = 0;
+    quint64 coalesced = 0;
+    quint64 retried = 0;
+    quint64 abandoned = 0; // Attempt budget spent without an answer
+  };
+
 signals:
-  void searchResults(const QJsonArray &tracks);
-  void trackStreamUrl(const QString &url);
-  void albumLoaded(const QJsonObject &albumData);
-  void artistLoaded(const QJsonObject &artistData);
-  void artistTopTracksLoaded(const QJsonArray &tracks);
-  void artistAlbumsLoaded(const QJsonArray &albums);
+  // total is the size of the whole result set, of which tracks is the page
+  // starting at offset
+  void searchResults(const QString &query, int offset, int total,
+                     const QList<Track> &tracks);
+  void trackStreamUrl(int trackId, const QString &url);
+  // Every mirror tried failed; errorOccurred carries the reason
+  void trackStreamFailed(int trackId);
+  void albumLoaded(const Album &album, const QList<Track> &tracks);
+  // Every retry failed; errorOccurred carries the reason
+  void albumFailed(int albumId);
+  void artistLoaded(const Artist &artist);
+  void artistTopTracksLoaded(const QList<Track> &tracks);
+  void artistAlbumsLoaded(const QList<Album> &albums);
   void errorOccurred(const QString &message);
+  // A copy of the counters and of every contacted mirror's breaker and
+  // rate limiter state, at most once a second while requests come and go
+  void statsChanged(const HifiClient::RequestStats &stats,
+                    const QList<RetryPolicy::MirrorStatus> &mirrors);
 
 private slots:
   void onSearchFinished();
@@ -45,30 +83,56 @@ private:
   QStringList apiEndpoints;
   int currentEndpointIndex;
 
+  // Re-posts call to the client's thread; false if already on it
+  template <typename Call> bool postToOwnThread(Call call) {
+    if (QThread::currentThread() == thread())
+      return false;
+    QMetaObject::invokeMethod(this, call);
+    return true;
+  }
+
   QString getCurrentBaseUrl() const;
   void rotateEndpoint();
 
-  // State for retries
-  QString lastQuery;
-  int lastTrackId = -1;
-  int lastAlbumId = -1;
-  int lastArtistId = -1;
-  enum class RequestType {
-    None,
-    Search,
-    Track,
-    Album,
-    Artist,
-    ArtistTopTracks,
-    ArtistAlbums
-  };
-  RequestType lastRequestType = RequestType::None;
+  // Mirrors the retry policy currently admits, starting at the current one
+  RetryPolicy *policy;
+  QStringList acquireEndpoints(int count);
+  QString acquireEndpoint();
+  void recordOutcome(QNetworkReply *reply);
+  // Schedules retry after a backoff; false once the attempt budget is spent
+  bool retryLater(int attempt, const std::function<void()> &retry);
+
+  // Single-flight: keys ("artist:42", ...) of requests currently in flight.
+  // A caller asking for a key already in the set attaches to that request and
+  // receives its result through the same signal emission.
+  QSet<QString> inFlight;
+  RequestStats stats;
+  QTimer *statsTimer;
+  void publishStats();
+  bool joinInFlight(const QString &key);
+  void leaveInFlight(const QString &key);
+
+  void requestAlbum(int albumId, int attempt = 0);
+  void requestArtist(int artistId, int attempt = 0);
+  void requestArtistTopTracks(int artistId, int attempt = 0);
+  void requestArtistAlbums(int artistId, int attempt = 0);
+  void retryAlbum(int albumId, int attempt);
+  void retryArtist(int artistId, int attempt);
+  void retryArtistTopTracks(int artistId, int attempt);
+  void retryArtistAlbums(int artistId, int attempt);
 
   // Parallel search
+  QString lastQuery;
+  int lastSearchOffset = 0;
   QList<QNetworkReply *> pendingSearchReplies;
-  void cancelPendingSearch();
+  QElapsedTimer searchTimer;
+  double searchLatencyMs = 0;
+  std::atomic<int> searchLatencyEstimate{0}; // Published for other threads
+  void recordSearchLatency();
 
-  // Parallel track stream
-  QList<QNetworkReply *> pendingTrackReplies;
-  void cancelPendingTrack();
+  // Parallel track stream, one group of mirror replies per track
+  QHash<int, QList<QNetworkReply *>> pendingTrackReplies;
+  void cancelPendingTrack(int trackId);
 };
+
+Q_DECLARE_METATYPE(HifiClient::RequestStats)
@@ -0,0 +1,504 @@
+#include "ResponseParser.hpp"
+#include <cstring>
+
+char JsonScanner::peek() {
+  while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t'))
+    ++p;
+  if (error || p >= end)
+    return 0;
+  return *p;
+}
+
+bool JsonScanner::enter(char open) {
+  if (peek() != open)
+    return false;
+  ++p;
+  return true;
+}
+
+const char *JsonScanner::skipString() {
+  for (const char *q = p + 1; q < end; ++q) {
+    if (*q == '\\') {
+      if (++q == end)
+        break;
+      continue;
+    }
+    if (*q == '"') {
+      p = q + 1;
+      return q;
+    }
+  }
+  error = true;
+  p = end;
+  return nullptr;
+}
+
+bool JsonScanner::nextKey(std::string_view &key) {
+  char c = peek();
+  if (c == ',') {
+    ++p;
+    c = peek();
+  }
+  if (c == '}') {
+    ++p;
+    return false;
+  }
+  if (c != '"') {
+    error = true;
+    return false;
+  }
+
+  // Keys we look up never contain escapes, so the raw bytes are compared
+  const char *start = p + 1;
+  const char *close = skipString();
+  if (!close)
+    return false;
+  key = std::string_view(start, close - start);
+
+  if (peek() != ':') {
+    error = true;
+    return false;
+  }
+  ++p;
+  return true;
+}
+
+bool JsonScanner::nextElement() {
+  char c = peek();
+  if (c == ',') {
+    ++p;
+    c = peek();
+  }
+  if (c == ']') {
+    ++p;
+    return false;
+  }
+  if (c == 0) {
+    error = true;
+    return false;
+  }
+  return true;
+}
+
+static QString unescape(const char *start, const char *close) {
+  QString out;
+  out.reserve(close - start);
+  const char *segment = start;
+  for (const char *q = start; q < close; ++q) {
+    if (*q != '\\')
+      continue;
+    out += QString::fromUtf8(segment, q - segment);
+    ++q;
+    switch (*q) {
+    case 'n':
+      out += QLatin1Char('\n');
+      break;
+    case 't':
+      out += QLatin1Char('\t');
+      break;
+    case 'r':
+      out += QLatin1Char('\r');
+      break;
+    case 'b':
+      out += QLatin1Char('\b');
+      break;
+    case 'f':
+      out += QLatin1Char('\f');
+      break;
+    case 'u':
+      // Surrogate pairs arrive as two escapes and recombine in UTF-16
+      if (close - q > 4) {
+        out += QChar(QByteArray(q + 1, 4).toUShort(nullptr, 16));
+        q += 4;
+      }
+      break;
+    default: // \" \\ \/
+      out += QLatin1Char(*q);
+      break;
+    }
+    segment = q + 1;
+  }
+  out += QString::fromUtf8(segment, close - segment);
+  return out;
+}
+
+QString JsonScanner::readString() {
+  if (peek() != '"') {
+    skipValue(); // null or a non-string value
+    return QString();
+  }
+  const char *start = p + 1;
+  const char *close = skipString();
+  if (!close)
+    return QString();
+
+  if (!std::memchr(start, '\\', close - start))
+    return QString::fromUtf8(start, close - start);
+  return unescape(start, close);
+}
+
+QByteArray JsonScanner::readStringBytes() {
+  if (peek() != '"') {
+    skipValue();
+    return QByteArray();
+  }
+  const char *start = p + 1;
+  const char *close = skipString();
+  if (!close)
+    return QByteArray();
+
+  if (!std::memchr(start, '\\', close - start))
+    return QByteArray::fromRawData(start, close - start);
+  // Some mirrors escape '/' inside base64 payloads
+  return unescape(start, close).toUtf8();
+}
+
+qint64 JsonScanner::readInteger() {
+  char c = peek();
+  if (c != '-' && (c < '0' || c > '9')) {
+    skipValue();
+    return 0;
+  }
+
+  bool negative = c == '-';
+  if (negative)
+    ++p;
+
+  qint64 value = 0;
+  while (p < end && *p >= '0' && *p <= '9')
+    value = value * 10 + (*p++ - '0');
+
+  // Fraction and exponent are truncated, like QJsonValue::toInt()
+  while (p < end && ((*p >= '0' && *p <= '9') || *p == '.' || *p == 'e' ||
+                     *p == 'E' || *p == '+' || *p == '-'))
+    ++p;
+
+  return negative ? -value : value;
+}
+
+void JsonScanner::skipValue() {
+  char c = peek();
+  if (c == '"') {
+    skipString();
+    return;
+  }
+
+  if (c == '{' || c == '[') {
+    int depth = 0;
+    while (p < end) {
+      char ch = *p;
+      if (ch == '"') {
+        if (!skipString())
+          return;
+        continue;
+      }
+      ++p;
+      if (ch == '{' || ch == '[') {
+        ++depth;
+      } else if ((ch == '}' || ch == ']') && --depth == 0) {
+        return;
+      }
+    }
+    error = true;
+    return;
+  }
+
+  // Number, true, false or null
+  const char *start = p;
+  while (p < end && *p != 0 && !std::strchr(",}] \t\r\n", *p))
+    ++p;
+  if (p == start)
+    error = true;
+}
+
+namespace {
+
+Artist readArtist(JsonScanner &s) {
+  Artist artist;
+  if (!s.beginObject()) {
+    s.skipValue();
+    return artist;
+  }
+  std::string_view key;
+  while (s.nextKey(key)) {
+    if (key == "id")
+      artist.id = int(s.readInteger());
+    else if (key == "name")
+      artist.name = s.readString();
+    else if (key == "bio")
+      artist.bio = s.readString();
+    else
+      s.skipValue();
+  }
+  return artist;
+}
+
+void readAlbumFields(JsonScanner &s, QString &title, QString &cover) {
+  if (!s.beginObject()) {
+    s.skipValue();
+    return;
+  }
+  std::string_view key;
+  while (s.nextKey(key)) {
+    if (key == "title")
+      title = s.readString();
+    else if (key == "cover")
+      cover = s.readString();
+    else
+      s.skipValue();
+  }
+}
+
+// Consumes the value for key if it is a track field we keep
+bool readTrackField(JsonScanner &s, std::string_view key, Track &track) {
+  if (key == "id") {
+    track.setId(int(s.readInteger()));
+  } else if (key == "title") {
+    track.setTitle(s.readString());
+  } else if (key == "duration") {
+    track.setDuration(int(s.readInteger()));
+  } else if (key == "artist") {
+    Artist artist = readArtist(s);
+    track.setArtist(artist.id, artist.name);
+  } else if (key == "album") {
+    QString title, cover;
+    readAlbumFields(s, title, cover);
+    track.setAlbum(title, cover);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Album listings wrap each entry as {"item": {..track..}, "type": "track"}
+Track readTrack(JsonScanner &s) {
+  Track track;
+  if (!s.beginObject()) {
+    s.skipValue();
+    return track;
+  }
+  std::string_view key;
+  while (s.nextKey(key)) {
+    if (key == "item")
+      track = readTrack(s);
+    else if (!readTrackField(s, key, track))
+      s.skipValue();
+  }
+  return track;
+}
+
+void readTrackArray(JsonScanner &s, QList<Track> &tracks) {
+  if (!s.beginArray()) {
+    s.skipValue();
+    return;
+  }
+  while (s.nextElement()) {
+    Track track = readTrack(s);
+    if (s.failed())
+      return; // Truncated reply: drop the partial element
+    tracks.append(track);
+  }
+}
+
+// Consumes the value for key if it is an album field we keep
+bool readAlbumField(JsonScanner &s, std::string_view key, Album &album) {
+  if (key == "id")
+    album.id = int(s.readInteger());
+  else if (key == "title")
+    album.title = s.readString();
+  else if (key == "cover")
+    album.cover = internString(s.readString());
+  else if (key == "artist")
+    album.artistName = internString(readArtist(s).name);
+  else
+    return false;
+  return true;
+}
+
+void readAlbumArray(JsonScanner &s, QList<Album> &albums) {
+  if (!s.beginArray()) {
+    s.skipValue();
+    return;
+  }
+  while (s.nextElement()) {
+    Album album;
+    if (!s.beginObject()) {
+      s.skipValue();
+      continue;
+    }
+    std::string_view key;
+    while (s.nextKey(key)) {
+      if (!readAlbumField(s, key, album))
+        s.skipValue();
+    }
+    if (s.failed())
+      return;
+    albums.append(album);
+  }
+}
+
+// One object of an /album/ response: metadata, a track page, or both
+void readAlbumPart(JsonScanner &s, Album &album, QList<Track> &tracks) {
+  if (!s.beginObject()) {
+    s.skipValue();
+    return;
+  }
+  std::string_view key;
+  while (s.nextKey(key)) {
+    if (key == "items")
+      readTrackArray(s, tracks);
+    else if (key == "album")
+      readAlbumPart(s, album, tracks);
+    else if (!readAlbumField(s, key, album))
+      s.skipValue();
+  }
+}
+
+QString readManifestUrl(const QByteArray &manifest) {
+  QByteArray decoded = QByteArray::fromBase64(manifest);
+  JsonScanner s(decoded);
+  if (!s.beginObject())
+    return QString();
+
+  std::string_view key;
+  while (s.nextKey(key)) {
+    if (key == "urls" && s.beginArray()) {
+      if (s.nextElement())
+        return s.readString();
+      return QString();
+    }
+    s.skipValue();
+  }
+  return QString();
+}
+
+// Stream URL from one track object, or empty if it carries no manifest
+QString readStreamObject(JsonScanner &s) {
+  if (!s.beginObject()) {
+    s.skipValue();
+    return QString();
+  }
+  // Read to the closing brace so an array of objects can go on
+  QString url;
+  std::string_view key;
+  while (s.nextKey(key)) {
+    if (key == "manifest")
+      url = readManifestUrl(s.readStringBytes());
+    else
+      s.skipValue();
+  }
+  return url;
+}
+
+} // namespace
+
+QList<Track> ResponseParser::parseTracks(const QByteArray &data, int *total) {
+  QList<Track> tracks;
+  JsonScanner s(data);
+
+  if (s.peek() == '[') {
+    readTrackArray(s, tracks);
+    return tracks;
+  }
+  if (!s.beginObject())
+    return tracks;
+
+  std::string_view key;
+  while (s.nextKey(key)) {
+    if (key == "tracks" && s.beginObject()) {
+      std::string_view inner;
+      while (s.nextKey(inner)) {
+        if (inner == "items")
+          readTrackArray(s, tracks);
+        else if (inner == "totalNumberOfItems" && total)
+          *total = int(s.readInteger());
+        else
+          s.skipValue();
+      }
+    } else if (key == "items" && tracks.isEmpty()) {
+      readTrackArray(s, tracks);
+    } else if (key == "totalNumberOfItems" && total) {
+      *total = int(s.readInteger());
+    } else {
+      s.skipValue();
+    }
+  }
+  return tracks;
+}
+
+Track ResponseParser::parseTrack(const QByteArray &data) {
+  JsonScanner s(data);
+  return readTrack(s);
+}
+
+QString ResponseParser::parseStreamUrl(const QByteArray &data) {
+  JsonScanner s(data);
+
+  // Of several track objects the last one with a URL wins, as it always has
+  if (s.beginArray()) {
+    QString streamUrl;
+    while (s.nextElement()) {
+      QString url = readStreamObject(s);
+      if (!url.isEmpty())
+        streamUrl = url;
+    }
+    return streamUrl;
+  }
+  return readStreamObject(s);
+}
+
+Artist ResponseParser::parseArtist(const QByteArray &data) {
+  Artist artist;
+  JsonScanner s(data);
+  if (!s.beginObject())
+    return artist;
+
+  // Fields sit at the root, or inside "artist" on newer mirrors
+  std::string_view key;
+  while (s.nextKey(key)) {
+    if (key == "artist" && s.peek() == '{')
+      artist = readArtist(s);
+    else if (key == "id")
+      artist.id = int(s.readInteger());
+    else if (key == "name")
+      artist.name = s.readString();
+    else if (key == "bio")
+      artist.bio = s.readString();
+    else
+      s.skipValue();
+  }
+  return artist;
+}
+
+QList<Album> ResponseParser::parseAlbums(const QByteArray &data) {
+  QList<Album> albums;
+  JsonScanner s(data);
+
+  if (s.peek() == '[') {
+    readAlbumArray(s, albums);
+    return albums;
+  }
+  if (!s.beginObject())
+    return albums;
+
+  std::string_view key;
+  while (s.nextKey(key)) {
+    if (key == "items")
+      readAlbumArray(s, albums);
+    else
+      s.skipValue();
+  }
+  return albums;
+}
+
+void ResponseParser::parseAlbum(const QByteArray &data, Album &album,
+                                QList<Track> &tracks) {
+  JsonScanner s(data);
+
+  if (s.beginArray()) {
+    while (s.nextElement())
+      readAlbumPart(s, album, tracks);
+    return;
+  }
+  readAlbumPart(s, album, tracks);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "../model/Track.hpp"
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+#include <string_view>
+
+// Forward-only JSON reader over a reply buffer. Values the caller does not ask
+// for are skipped in place, so no DOM is built and nothing is allocated for
+// them. Malformed input makes every read return an empty value.
+class JsonScanner {
+public:
+  explicit JsonScanner(const QByteArray &data)
+      : p(data.constData()), end(data.constData() + data.size()) {}
+
+  bool failed() const { return error; }
+
+  // Next significant character, or 0 at the end of input
+  char peek();
+
+  // Enter a container; returns false (consuming nothing) on a type mismatch
+  bool beginObject() { return enter('{'); }
+  bool beginArray() { return enter('['); }
+
+  // Advance to the next member / element of the current container. Returns
+  // false after consuming the closing bracket. The caller must then read or
+  // skip exactly one value.
+  bool nextKey(std::string_view &key);
+  bool nextElement();
+
+  QString readString();
+  // Raw bytes of a string without escapes, sharing the scanned buffer
+  QByteArray readStringBytes();
+  qint64 readInteger();
+  void skipValue();
+
+private:
+  const char *p;
+  const char *end;
+  bool error = false;
+
+  bool enter(char open);
+  const char *skipString(); // p at opening quote; returns closing quote
+};
+
+namespace ResponseParser {
+
+// Search results ({"tracks":{"items":[..]}}, {"items":[..]}) and top tracks.
+// total receives totalNumberOfItems when the reply is one page of a listing.
+QList<Track> parseTracks(const QByteArray &data, int *total = nullptr);
+
+// A single track object, as older rows stored it in favorites.json_data
+Track parseTrack(const QByteArray &data);
+
+// Stream URL from a /track/ response: the first URL of the manifest, and of
+// an array of objects the last one that has a manifest URL
+QString parseStreamUrl(const QByteArray &data);
+
+Artist parseArtist(const QByteArray &data);
+
+// Artist discography: an array or {"items":[..]} of album objects
+QList<Album> parseAlbums(const QByteArray &data);
+
+// /album/ response: album metadata plus its track listing, either as one
+// object or split across the elements of a top-level array
+void parseAlbum(const QByteArray &data, Album &album, QList<Track> &tracks);
+
+} // namespace ResponseParser
@@ -0,0 +1,108 @@
+#include "RetryPolicy.hpp"
+#include <QDebug>
+#include <QRandomGenerator>
+
+namespace {
+const int failureThreshold = 3;  // Consecutive failures that open a breaker
+const qint64 openCooldownMs = 30000;
+const double bucketCapacity = 5; // Burst per mirror
+const double refillPerSecond = 2;
+const int backoffBaseMs = 500;
+const int backoffCapMs = 8000;
+} // namespace
+
+RetryPolicy::RetryPolicy(QObject *parent) : QObject(parent) { clock.start(); }
+
+void RetryPolicy::refill(Mirror &m) {
+  qint64 now = clock.elapsed();
+  if (m.tokens < 0) {
+    m.tokens = bucketCapacity;
+  } else {
+    m.tokens = qMin(bucketCapacity,
+                    m.tokens + (now - m.refilledAt) * refillPerSecond / 1000.0);
+  }
+  m.refilledAt = now;
+}
+
+void RetryPolicy::setState(const QString &mirror, Mirror &m,
+                           BreakerState state) {
+  if (m.state == state)
+    return;
+  m.state = state;
+  if (state == Open)
+    m.openedAt = clock.elapsed();
+  qDebug() << "RetryPolicy:" << mirror << "breaker" << state;
+  emit breakerStateChanged(mirror, state);
+}
+
+bool RetryPolicy::tryAcquire(const QString &mirror) {
+  Mirror &m = mirrors[mirror];
+
+  if (m.state == Open && clock.elapsed() - m.openedAt >= openCooldownMs)
+    setState(mirror, m, HalfOpen);
+
+  // Half-open lets a single probe through to test the mirror
+  if (m.state == Open || (m.state == HalfOpen && m.probeInFlight)) {
+    m.rejected++;
+    return false;
+  }
+
+  refill(m);
+  if (m.tokens < 1) {
+    m.rejected++;
+    return false;
+  }
+  m.tokens -= 1;
+  m.requests++;
+  if (m.state == HalfOpen)
+    m.probeInFlight = true;
+  return true;
+}
+
+void RetryPolicy::recordSuccess(const QString &mirror) {
+  Mirror &m = mirrors[mirror];
+  m.consecutiveFailures = 0;
+  m.probeInFlight = false;
+  setState(mirror, m, Closed);
+}
+
+void RetryPolicy::recordFailure(const QString &mirror) {
+  Mirror &m = mirrors[mirror];
+  m.failures++;
+  m.consecutiveFailures++;
+  m.probeInFlight = false;
+  if (m.state == HalfOpen || m.consecutiveFailures >= failureThreshold)
+    setState(mirror, m, Open);
+}
+
+void RetryPolicy::recordRateLimited(const QString &mirror) {
+  Mirror &m = mirrors[mirror];
+  refill(m);
+  m.tokens = 0;
+  recordFailure(mirror);
+}
+
+void RetryPolicy::recordCancelled(const QString &mirror) {
+  mirrors[mirror].probeInFlight = false;
+}
+
+int RetryPolicy::backoffDelay(int attempt) const {
+  int ceiling = backoffBaseMs << qMin(attempt, 10);
+  return QRandomGenerator::global()->bounded(qMin(ceiling, backoffCapMs) + 1);
+}
+
+QList<RetryPolicy::MirrorStatus> RetryPolicy::mirrorStatus() const {
+  QList<MirrorStatus> list;
+  for (auto it = mirrors.constBegin(); it != mirrors.constEnd(); ++it) {
+    MirrorStatus status;
+    status.mirror = it.key();
+    status.state = it->state;
+    status.consecutiveFailures = it->consecutiveFailures;
+    status.tokens = qMax(0.0, it->tokens);
+    status.requests = it->requests;
+    status.failures = it->failures;
+    status.rejected = it->rejected;
+    list.append(status);
+  }
+  return list;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+
+// Shared failure handling for the mirror requests: a per-request attempt
+// budget with jittered exponential backoff, and per-mirror circuit breakers
+// and token buckets so dead or throttling mirrors stop receiving traffic.
+class RetryPolicy : public QObject {
+  Q_OBJECT
+
+public:
+  enum BreakerState { Closed, Open, HalfOpen };
+  Q_ENUM(BreakerState)
+
+  struct MirrorStatus {
+    QString mirror;
+    BreakerState state = Closed;
+    int consecutiveFailures = 0;
+    double tokens = 0;
+    quint64 requests = 0;
+    quint64 failures = 0;
+    quint64 rejected = 0; // Refused by the breaker or the token bucket
+  };
+
+  explicit RetryPolicy(QObject *parent = nullptr);
+
+  // Takes a token for one request to mirror. Returns false while its breaker
+  // is open, while a half-open probe is already out, or when it is out of
+  // tokens.
+  bool tryAcquire(const QString &mirror);
+
+  void recordSuccess(const QString &mirror);
+  void recordFailure(const QString &mirror);
+  // HTTP 429: a failure that also empties the bucket
+  void recordRateLimited(const QString &mirror);
+  // Aborted by us: says nothing about the mirror, but frees a half-open probe
+  void recordCancelled(const QString &mirror);
+
+  // Attempts a request may make, first try included
+  int maxAttempts() const { return 4; }
+  // Delay in ms before retry number attempt (0-based), with full jitter
+  int backoffDelay(int attempt) const;
+
+  QList<MirrorStatus> mirrorStatus() const;
+
+signals:
+  void breakerStateChanged(const QString &mirror,
+                           RetryPolicy::BreakerState state);
+
+private:
+  struct Mirror {
+    BreakerState state = Closed;
+    int consecutiveFailures = 0;
+    qint64 openedAt = 0;
+    bool probeInFlight = false;
+    double tokens = -1; // Filled to capacity on first use
+    qint64 refilledAt = 0;
+    quint64 requests = 0;
+    quint64 failures = 0;
+    quint64 rejected = 0;
+  };
+
+  QHash<QString, Mirror> mirrors;
+  QElapsedTimer clock;
+
+  void refill(Mirror &m);
+  void setState(const QString &mirror, Mirror &m, BreakerState state);
+};
+
+Q_DECLARE_METATYPE(RetryPolicy::MirrorStatus)
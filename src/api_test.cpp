@@ -1,4 +1,5 @@
 #include "api/HifiClient.hpp"
+#include "net/NetworkAccess.hpp"
 #include <QCoreApplication>
 #include <QDebug>
 #include <QTimer>
@@ -6,15 +7,18 @@
 int main(int argc, char *argv[]) {
   QCoreApplication app(argc, argv);
   HifiClient client;
+  client.moveToThread(NetworkAccess::instance().ioThread());
 
+  // Results are delivered back to the main thread, as in the app
   QObject::connect(
-      &client, &HifiClient::searchResults, [&](const QJsonArray &tracks) {
+      &client, &HifiClient::searchResults, &app,
+      [&](const QString &, int, int, const QList<Track> &tracks) {
         qDebug() << "Search successful! Found" << tracks.size() << "tracks.";
         if (!tracks.isEmpty()) {
-          QJsonObject first = tracks[0].toObject();
-          qDebug() << "First track:" << first["title"].toString();
+          const Track &first = tracks.first();
+          qDebug() << "First track:" << first.title();
           // Try to get stream for first track
-          int id = first["id"].toInt();
+          int id = first.id();
           qDebug() << "Fetching stream for track" << id;
           client.getTrackStream(id);
         } else {
@@ -22,13 +26,13 @@ int main(int argc, char *argv[]) {
         }
       });
 
-  QObject::connect(&client, &HifiClient::trackStreamUrl,
-                   [&](const QString &url) {
+  QObject::connect(&client, &HifiClient::trackStreamUrl, &app,
+                   [&](int, const QString &url) {
                      qDebug() << "Stream URL retrieved:" << url;
                      app.quit();
                    });
 
-  QObject::connect(&client, &HifiClient::errorOccurred,
+  QObject::connect(&client, &HifiClient::errorOccurred, &app,
                    [&](const QString &msg) {
                      qDebug() << "Error:" << msg;
                      // Don't quit immediately on error, client might be
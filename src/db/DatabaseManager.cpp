@@ -1,8 +1,15 @@
 #include "DatabaseManager.hpp"
+#include "../api/ResponseParser.hpp"
+#include <QDateTime>
 #include <QDebug>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QCborValue>
 #include <QJsonDocument>
+#include <QJsonObject>
+#include <QScopeGuard>
 #include <QSqlError>
 #include <QSqlQuery>
 #include <QStandardPaths>
@@ -12,16 +19,68 @@ DatabaseManager &DatabaseManager::instance() {
   return instance;
 }
 
+// Pooled readers; WAL lets them run alongside the writer
+static const int readConnections = 3;
+
 DatabaseManager::DatabaseManager(QObject *parent) : QObject(parent) {
   initDatabase();
+  loadMembership();
+
+  writerThread = new QThread(this);
+  writerThread->setObjectName("db-writer");
+  writerContext = new QObject;
+  writerContext->moveToThread(writerThread);
+  writerThread->start();
+
+  readPool = new QThreadPool(this);
+  readPool->setMaxThreadCount(readConnections);
+  readPool->setExpiryTimeout(-1); // Threads keep their open connections
 }
 
 DatabaseManager::~DatabaseManager() {
-  if (m_db.isOpen()) {
-    m_db.close();
+  // Worker connections close as their threads exit
+  writerThread->quit();
+  writerThread->wait();
+  delete writerContext;
+  readPool->waitForDone();
+}
+
+DatabaseManager::Connection::~Connection() {
+  // Statements must be released before their connection closes
+  qDeleteAll(statements);
+  QString name = db.connectionName();
+  db.close();
+  db = QSqlDatabase();
+  QSqlDatabase::removeDatabase(name);
+}
+
+DatabaseManager::Connection &DatabaseManager::connection() {
+  if (!connections.hasLocalData()) {
+    auto *opened = new Connection;
+    QString name =
+        QString("hellyeah-%1").arg(quintptr(QThread::currentThreadId()));
+    opened->db = QSqlDatabase::addDatabase("QSQLITE", name);
+    opened->db.setDatabaseName(dbPath);
+    if (!opened->db.open())
+      qDebug() << "Error: connection with database failed"
+               << opened->db.lastError();
+
+    QSqlQuery query(opened->db);
+    // With WAL, NORMAL only syncs at checkpoints: a power cut may lose the
+    // last commits but cannot corrupt the file
+    query.exec("PRAGMA synchronous=NORMAL");
+    query.exec("PRAGMA cache_size=-8192");    // KiB
+    query.exec("PRAGMA mmap_size=67108864"); // Reads skip a copy via the map
+    query.exec("PRAGMA temp_store=MEMORY");
+    // Writers on other threads wait their turn instead of failing
+    query.exec("PRAGMA busy_timeout=5000");
+    connections.setLocalData(opened);
   }
+  return *connections.localData();
 }
 
+QSqlDatabase DatabaseManager::database() { return connection().db; }
+
 void DatabaseManager::initDatabase() {
   QString dataPath =
       QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
@@ -29,154 +88,360 @@ void DatabaseManager::initDatabase() {
   if (!dir.exists()) {
     dir.mkpath(".");
   }
+  dbPath = dir.filePath("hellyeah.db");
 
-  QString dbPath = dir.filePath("hellyeah.db");
-  m_db = QSqlDatabase::addDatabase("QSQLITE");
-  m_db.setDatabaseName(dbPath);
-
-  if (!m_db.open()) {
-    qDebug() << "Error: connection with database failed" << m_db.lastError();
-  } else {
+  QSqlQuery query(database());
+  if (database().isOpen())
     qDebug() << "Database: connection ok";
+  // WAL appends commits instead of rewriting pages through a rollback
+  // journal, and readers no longer wait for the writer. It is stored in the
+  // file, so every later connection uses it.
+  query.exec("PRAGMA journal_mode=WAL");
+  migrate();
+}
+
+// The schema version user_version should reach. Add a step to migrateTo()
+// for each bump; steps already applied never run again.
+static const int schemaVersion = 3;
+
+// Applies each step with its user_version bump in one transaction, so an
+// interrupted upgrade leaves the previous version intact
+void DatabaseManager::migrate() {
+  QSqlDatabase db = database();
+  QSqlQuery query(db);
+  int version = 0;
+  if (query.exec("PRAGMA user_version") && query.next())
+    version = query.value(0).toInt();
+  query.finish();
+
+  while (version < schemaVersion) {
+    int next = version + 1;
+    bool ok = db.transaction() && migrateTo(next) &&
+              query.exec(QString("PRAGMA user_version = %1").arg(next));
+    if (!ok || !db.commit()) {
+      qDebug() << "Migration to schema" << next
+               << "failed:" << query.lastError() << db.lastError();
+      db.rollback();
+      coverMoves.clear();
+      return;
+    }
+    moveCovers();
+    qDebug() << "Migrated database to schema" << next;
+    version = next;
   }
+}
 
-  QSqlQuery query;
-  query.exec("CREATE TABLE IF NOT EXISTS favorites ("
-             "id INTEGER PRIMARY KEY, "
-             "title TEXT, "
-             "artist TEXT, "
-             "album TEXT, "
-             "cover_id TEXT, "
-             "file_path TEXT, "
-             "cover_path TEXT, "
-             "json_data TEXT)");
-
-  // Migration: Ensure cover_path exists for existing databases
-  if (!query.exec("SELECT cover_path FROM favorites LIMIT 1")) {
-    qDebug() << "Migrating database: adding cover_path column";
-    query.exec("ALTER TABLE favorites ADD COLUMN cover_path TEXT");
-  }
-
-  // Migration: Ensure is_favorite exists
-  if (!query.exec("SELECT is_favorite FROM favorites LIMIT 1")) {
-    qDebug() << "Migrating database: adding is_favorite column";
-    query.exec(
-        "ALTER TABLE favorites ADD COLUMN is_favorite INTEGER DEFAULT 1");
-  }
-
-  query.exec("CREATE TABLE IF NOT EXISTS albums ("
-             "id INTEGER PRIMARY KEY AUTOINCREMENT, "
-             "name TEXT, "
-             "cover_id TEXT, "
-             "id INTEGER PRIMARY KEY AUTOINCREMENT, "
-             "name TEXT, "
-             "cover_id TEXT, "
-             "cover_path TEXT, "
-             "created_at INTEGER)");
-
-  // Migration: Ensure cover_path exists for existing albums table
-  if (!query.exec("SELECT cover_path FROM albums LIMIT 1")) {
-    qDebug() << "Migrating database: adding cover_path column to albums";
-    query.exec("ALTER TABLE albums ADD COLUMN cover_path TEXT");
-  }
-
-  query.exec("CREATE TABLE IF NOT EXISTS album_tracks ("
-             "album_id INTEGER, "
-             "track_id INTEGER, "
-             "added_at INTEGER, "
-             "PRIMARY KEY (album_id, track_id))");
-}
-
-bool DatabaseManager::addFavorite(const QJsonObject &track) {
-  QSqlQuery query;
-  // Check if exists first to preserve other fields if needed, or just REPLACE
-  // We want to set is_favorite = 1
-
-  // First, check if it exists
-  QSqlQuery check;
-  check.prepare("SELECT id FROM favorites WHERE id = :id");
-  check.bindValue(":id", track["id"].toInt());
-  if (check.exec() && check.next()) {
-    // Update
-    query.prepare(
-        "UPDATE favorites SET is_favorite = 1, title = :title, artist = "
-        ":artist, "
-        "album = :album, cover_id = :cover_id, json_data = :json_data "
-        "WHERE id = :id");
-  } else {
-    // Insert
-    query.prepare("INSERT INTO favorites (id, title, artist, album, cover_id, "
-                  "json_data, cover_path, is_favorite) "
-                  "VALUES (:id, :title, :artist, :album, :cover_id, "
-                  ":json_data, :cover_path, 1)");
-  }
-
-  int id = track["id"].toInt();
-  QString title = track["title"].toString();
-  QString artist = track["artist"].toObject()["name"].toString();
-  QString album = track["album"].toObject()["title"].toString();
-  QString coverId = track["album"].toObject()["cover"].toString();
-  QString jsonData = QJsonDocument(track).toJson(QJsonDocument::Compact);
-
-  query.bindValue(":id", id);
-  query.bindValue(":title", title);
-  query.bindValue(":artist", artist);
-  query.bindValue(":album", album);
-  query.bindValue(":cover_id", coverId);
-  query.bindValue(":json_data", jsonData);
-
-  // Check if we have a cover path
-  QString coverPath = "";
-  if (track.contains("coverPath")) {
-    coverPath = track["coverPath"].toString();
-    if (!coverPath.isEmpty()) {
-      // If we are updating, we might want to keep existing cover path if new
-      // one is empty? But here we bind it. Let's assume if we are adding a
-      // favorite, we might not have the path yet.
+static QStringList tableColumns(QSqlDatabase db, const QString &table) {
+  QStringList columns;
+  QSqlQuery query(db);
+  query.exec("PRAGMA table_info(" + table + ")");
+  while (query.next())
+    columns.append(query.value(1).toString());
+  return columns;
+}
+
+bool DatabaseManager::migrateTo(int version) {
+  QSqlDatabase db = database();
+  QSqlQuery query(db);
+  bool ok = true;
+  auto exec = [&query, &ok](const QString &sql) {
+    if (!query.exec(sql)) {
+      qDebug() << "Migration error:" << query.lastError() << sql;
+      ok = false;
     }
+  };
+
+  switch (version) {
+  case 1: {
+    // The tables as they stand. Databases from before versioning have them
+    // with whichever columns they were given since, so add what is missing.
+    exec("CREATE TABLE IF NOT EXISTS favorites ("
+         "id INTEGER PRIMARY KEY, "
+         "title TEXT, "
+         "artist TEXT, "
+         "album TEXT, "
+         "cover_id TEXT, "
+         "file_path TEXT, "
+         "cover_path TEXT, "
+         "json_data BLOB)");
+    const QStringList favorites = tableColumns(db, "favorites");
+    const QList<QPair<QString, QString>> added = {
+        {"cover_path", "TEXT"},
+        {"is_favorite", "INTEGER DEFAULT 1"},
+        {"last_played_at", "INTEGER"},
+        {"play_count", "INTEGER DEFAULT 0"},
+        {"artist_id", "INTEGER"},
+        {"duration", "INTEGER"},
+        {"added_at", "INTEGER DEFAULT 0"}};
+    for (const auto &column : added) {
+      if (!favorites.contains(column.first))
+        exec("ALTER TABLE favorites ADD COLUMN " + column.first + " " +
+             column.second);
+    }
+    // Rows saved as JSON only
+    if (!favorites.contains("duration"))
+      migrateTrackColumns();
+
+    exec("CREATE TABLE IF NOT EXISTS albums ("
+         "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+         "name TEXT, "
+         "cover_id TEXT, "
+         "cover_path TEXT, "
+         "created_at INTEGER)");
+    if (!tableColumns(db, "albums").contains("cover_path"))
+      exec("ALTER TABLE albums ADD COLUMN cover_path TEXT");
+
+    exec("CREATE TABLE IF NOT EXISTS album_tracks ("
+         "album_id INTEGER, "
+         "track_id INTEGER, "
+         "added_at INTEGER, "
+         "PRIMARY KEY (album_id, track_id))");
+
+    exec("CREATE TABLE IF NOT EXISTS download_queue ("
+         "track_id INTEGER PRIMARY KEY, "
+         "url TEXT, "
+         "state TEXT, "
+         "bytes_done INTEGER DEFAULT 0, "
+         "total_bytes INTEGER DEFAULT 0, "
+         "etag TEXT, "
+         "last_modified TEXT, "
+         "retry_count INTEGER DEFAULT 0, "
+         "updated_at INTEGER)");
+
+    exec("CREATE TABLE IF NOT EXISTS covers ("
+         "cover_id TEXT PRIMARY KEY, "
+         "file_path TEXT, "
+         "created_at INTEGER)");
+    migrateCoverStore();
+    break;
   }
-  // If insert, we bind cover_path. If update, we didn't include cover_path in
-  // the UPDATE query above? Wait, the UPDATE query above didn't include
-  // cover_path. Let's fix the UPDATE query to include cover_path only if it's
-  // provided? Or just use REPLACE logic but ensure is_favorite=1.
-
-  // Actually, REPLACE INTO deletes and inserts, which might lose cover_path if
-  // we don't provide it? Yes. So explicit INSERT OR UPDATE is better.
-
-  // Let's simplify:
-  // If we are just toggling favorite, we might not have coverPath in the track
-  // object if it came from API. But we want to keep the local file path and
-  // cover path if they exist.
-
-  // So:
-  // 1. Upsert logic.
-
-  if (check.exec() && check.next()) {
-    // Exists. Update is_favorite.
-    // Also update metadata in case it changed?
-    query.prepare("UPDATE favorites SET is_favorite = 1, json_data = "
-                  ":json_data WHERE id = :id");
-    query.bindValue(":json_data", jsonData);
-    query.bindValue(":id", id);
+  case 2:
+    // Keyset pages seek these instead of sorting; rowid completes each key
+    exec("CREATE INDEX IF NOT EXISTS favorites_by_added "
+         "ON favorites (is_favorite, added_at)");
+    exec("CREATE INDEX IF NOT EXISTS album_tracks_by_added "
+         "ON album_tracks (album_id, added_at)");
+    // Cover reference counts, without reading table rows
+    exec("CREATE INDEX IF NOT EXISTS favorites_by_cover "
+         "ON favorites (cover_id, is_favorite)");
+    exec("CREATE INDEX IF NOT EXISTS album_tracks_by_track "
+         "ON album_tracks (track_id)");
+    exec("CREATE INDEX IF NOT EXISTS albums_by_cover ON albums (cover_id)");
+    exec("CREATE INDEX IF NOT EXISTS albums_by_cover_path "
+         "ON albums (cover_path)");
+    break;
+  case 3:
+    // The Tidal album a saved album was made from, so loading it again
+    // fills the same one; NULL for albums the user made
+    exec("ALTER TABLE albums ADD COLUMN source_album_id INTEGER");
+    exec("CREATE UNIQUE INDEX IF NOT EXISTS albums_by_source "
+         "ON albums (source_album_id)");
+    break;
+  default:
+    qDebug() << "No migration to schema" << version;
+    return false;
+  }
+  return ok;
+}
+
+QSqlQuery &DatabaseManager::cachedQuery(const QString &sql) {
+  Connection &current = connection();
+  QSqlQuery *&query = current.statements[sql];
+  if (!query) {
+    query = new QSqlQuery(current.db);
   } else {
-    // New insert
-    query.prepare("INSERT INTO favorites (id, title, artist, album, cover_id, "
-                  "json_data, cover_path, is_favorite) "
-                  "VALUES (:id, :title, :artist, :album, :cover_id, "
-                  ":json_data, :cover_path, 1)");
-    query.bindValue(":id", id);
-    query.bindValue(":title", title);
-    query.bindValue(":artist", artist);
-    query.bindValue(":album", album);
-    query.bindValue(":cover_id", coverId);
-    query.bindValue(":json_data", jsonData);
-    query.bindValue(":cover_path", coverPath);
+    query->finish(); // Resets the statement; the plan is kept
+    return *query;
   }
+  if (!query->prepare(sql))
+    qDebug() << "prepare error:" << query->lastError() << sql;
+  return *query;
+}
 
-  if (!query.exec()) {
-    qDebug() << "addFavorite error:" << query.lastError();
+// Covers used to be saved per track as covers/<trackId>.jpg. Points the rows
+// at each UUID's file; moveCovers() moves the files once this commits.
+void DatabaseManager::migrateCoverStore() {
+  QSqlQuery select("SELECT id, cover_id, cover_path FROM favorites "
+                   "WHERE cover_id IS NOT NULL AND cover_id != '' "
+                   "AND cover_path IS NOT NULL AND cover_path != ''",
+                   database());
+  QHash<QString, QString> moved; // Old path to store path
+  while (select.next()) {
+    QString coverId = select.value(1).toString();
+    QString oldPath = select.value(2).toString();
+    QString storePath = coverStorePath(coverId);
+    if (oldPath == storePath ||
+        (!QFile::exists(oldPath) && !QFile::exists(storePath)))
+      continue;
+    coverMoves.append({oldPath, storePath});
+    moved.insert(oldPath, storePath);
+    storeCover(coverId, storePath);
+  }
+
+  for (auto it = moved.constBegin(); it != moved.constEnd(); ++it) {
+    QSqlQuery &update = cachedQuery(
+        "UPDATE albums SET cover_path = :new WHERE cover_path = :old");
+    update.bindValue(":new", it.value());
+    update.bindValue(":old", it.key());
+    update.exec();
+  }
+  if (!moved.isEmpty())
+    qDebug() << "Migrated" << moved.size() << "covers into the cover store";
+}
+
+// Moves each cover to its UUID's file, dropping the copies other tracks of
+// the album had. Run only after the step that planned it has committed, so
+// a rolled back step leaves the files where its rows say they are.
+void DatabaseManager::moveCovers() {
+  for (const auto &move : std::as_const(coverMoves)) {
+    if (!QFile::exists(move.first))
+      continue;
+    if (!QFile::exists(move.second))
+      QFile::rename(move.first, move.second);
+    else
+      QFile::remove(move.first);
+  }
+  coverMoves.clear();
+}
+
+// Fills the typed columns of rows saved as JSON only. Their wire object stays
+// in json_data, converted as it was to compact CBOR; rows saved since have
+// only the columns. The caller holds the transaction.
+void DatabaseManager::migrateTrackColumns() {
+  QSqlDatabase db = database();
+  QSqlQuery select("SELECT id, json_data FROM favorites "
+                   "WHERE json_data IS NOT NULL",
+                   db);
+  QSqlQuery update(db);
+  update.prepare("UPDATE favorites SET title = :title, "
+                 "artist_id = :artist_id, artist = :artist, album = :album, "
+                 "cover_id = :cover_id, duration = :duration, "
+                 "json_data = :json_data WHERE id = :id");
+  int migrated = 0;
+  while (select.next()) {
+    QByteArray raw = select.value(1).toString().toUtf8();
+    Track track = ResponseParser::parseTrack(raw);
+    if (track.id() == 0)
+      continue;
+    update.bindValue(":title", track.title());
+    update.bindValue(":artist_id", track.artistId());
+    update.bindValue(":artist", track.artistName());
+    update.bindValue(":album", track.albumTitle());
+    update.bindValue(":cover_id", track.cover());
+    update.bindValue(":duration", track.duration());
+    update.bindValue(
+        ":json_data",
+        QCborValue::fromJsonValue(QJsonDocument::fromJson(raw).object())
+            .toCbor());
+    update.bindValue(":id", select.value(0).toInt());
+    if (update.exec())
+      migrated++;
+  }
+  select.finish();
+  qDebug() << "Migrated" << migrated << "tracks to typed columns";
+}
+
+// Columns trackFromRow() reads, in order
+static const QString trackColumns =
+    QStringLiteral("f.id, f.title, f.artist_id, f.artist, f.album, "
+                   "f.cover_id, f.duration, f.file_path, f.cover_path");
+
+Track DatabaseManager::trackFromRow(const QSqlQuery &query) {
+  Track track;
+  track.setId(query.value(0).toInt());
+  track.setTitle(query.value(1).toString());
+  track.setArtist(query.value(2).toInt(), query.value(3).toString());
+  track.setAlbum(query.value(4).toString(), query.value(5).toString());
+  track.setDuration(query.value(6).toInt());
+  track.setFilePath(query.value(7).toString());
+  track.setCoverPath(query.value(8).toString());
+  return track;
+}
+
+// Rows per multi-row statement; rows times columns stays under the 999 host
+// parameters older SQLite builds allow
+static const int rowsPerStatement = 90;
+
+// Rows for the next statement: full ones while they fit, then one at a time,
+// so each connection caches two shapes of a statement, not one per size
+static qsizetype chunkRows(qsizetype remaining) {
+  return remaining >= rowsPerStatement ? rowsPerStatement : 1;
+}
+
+// "(?, ?), (?, ?)" for rows of columns
+static QString placeholders(int rows, int columns) {
+  QString row = "(" + QStringList(columns, "?").join(", ") + ")";
+  return QStringList(rows, row).join(", ");
+}
+
+bool DatabaseManager::insertTracks(const QList<Track> &tracks, bool favorite) {
+  // A new favorite is stored whole; an existing row only turns into one and
+  // takes the fresh metadata, so its file and cover paths survive. Other
+  // tracks leave existing rows alone.
+  QString onConflict =
+      favorite ? "ON CONFLICT(id) DO UPDATE SET "
+                 "added_at = CASE WHEN is_favorite = 1 THEN added_at "
+                 "ELSE excluded.added_at END, is_favorite = 1, "
+                 "title = excluded.title, artist_id = excluded.artist_id, "
+                 "artist = excluded.artist, album = excluded.album, "
+                 "cover_id = excluded.cover_id, "
+                 "duration = excluded.duration"
+               : "ON CONFLICT(id) DO NOTHING";
+  // A new row takes the file of its cover if the store has one, so
+  // cover_path always names a file on disk
+  const QString row = "(?, ?, ?, ?, ?, ?, ?, COALESCE(NULLIF(?, ''), "
+                      "(SELECT file_path FROM covers WHERE cover_id = ?)), "
+                      "?, ?)";
+  qint64 addedAt = QDateTime::currentSecsSinceEpoch();
+  for (qsizetype start = 0, rows; start < tracks.size(); start += rows) {
+    rows = chunkRows(tracks.size() - start);
+    const QList<Track> chunk = tracks.mid(start, rows);
+    QSqlQuery &query = cachedQuery(
+        "INSERT INTO favorites (id, title, artist_id, artist, album, "
+        "cover_id, duration, cover_path, is_favorite, added_at) "
+        "VALUES " +
+        QStringList(rows, row).join(", ") + " " + onConflict);
+    for (const Track &track : chunk) {
+      query.addBindValue(track.id());
+      query.addBindValue(track.title());
+      query.addBindValue(track.artistId());
+      query.addBindValue(track.artistName());
+      query.addBindValue(track.albumTitle());
+      query.addBindValue(track.cover());
+      query.addBindValue(track.duration());
+      query.addBindValue(track.coverPath());
+      query.addBindValue(track.cover());
+      query.addBindValue(favorite ? 1 : 0);
+      query.addBindValue(addedAt);
+    }
+    if (!query.exec()) {
+      qDebug() << "insertTracks error:" << query.lastError();
+      return false;
+    }
+  }
+  return true;
+}
+
+bool DatabaseManager::addFavorite(const Track &track) {
+  return addFavorites({track});
+}
+
+bool DatabaseManager::addFavorites(const QList<Track> &tracks) {
+  QSqlDatabase db = database();
+  if (!db.transaction()) {
+    qDebug() << "addFavorites error:" << db.lastError();
+    return false;
+  }
+  if (!insertTracks(tracks, true)) {
+    db.rollback();
     return false;
   }
+  if (!db.commit())
+    return false;
+
+  QWriteLocker locker(&membershipLock);
+  for (const Track &track : tracks)
+    favoriteIds.insert(track.id());
   return true;
 }
 
@@ -186,70 +451,142 @@ bool DatabaseManager::removeFavorite(int trackId) {
   // For now, just set is_favorite = 0.
   // We keep the files.
 
-  QSqlQuery query;
-  query.prepare("UPDATE favorites SET is_favorite = 0 WHERE id = :id");
+  QSqlQuery &query =
+      cachedQuery("UPDATE favorites SET is_favorite = 0 WHERE id = :id");
   query.bindValue(":id", trackId);
 
   if (query.exec()) {
+    QWriteLocker locker(&membershipLock);
+    favoriteIds.remove(trackId);
     return true;
   }
   qDebug() << "removeFavorite error:" << query.lastError();
   return false;
 }
 
-bool DatabaseManager::isFavorite(int trackId) {
-  QSqlQuery query;
-  query.prepare("SELECT id FROM favorites WHERE id = :id AND is_favorite = 1");
-  query.bindValue(":id", trackId);
-  if (query.exec() && query.next()) {
-    return true;
+bool DatabaseManager::isFavorite(int trackId) const {
+  QReadLocker locker(&membershipLock);
+  return favoriteIds.contains(trackId);
+}
+
+QList<int> DatabaseManager::albumsWithTrack(int trackId) const {
+  QReadLocker locker(&membershipLock);
+  QList<int> albums;
+  for (auto it = albumTrackIds.cbegin(); it != albumTrackIds.cend(); ++it) {
+    if (it->contains(trackId))
+      albums.append(it.key());
   }
-  return false;
+  return albums;
 }
 
-QList<QJsonObject> DatabaseManager::getFavorites() {
-  QList<QJsonObject> list;
-  QSqlQuery query("SELECT json_data, file_path, cover_path FROM favorites "
-                  "WHERE is_favorite = 1");
-  while (query.next()) {
-    QString jsonStr = query.value("json_data").toString();
-    QJsonDocument doc = QJsonDocument::fromJson(jsonStr.toUtf8());
-    QJsonObject track = doc.object();
+// Two index-only scans; the sets then follow every write that commits
+void DatabaseManager::loadMembership() {
+  QSet<int> favorites;
+  QHash<int, QSet<int>> albums;
+  QSqlQuery query(database());
+  query.setForwardOnly(true);
+  query.exec("SELECT id FROM favorites WHERE is_favorite = 1");
+  while (query.next())
+    favorites.insert(query.value(0).toInt());
+  query.exec("SELECT album_id, track_id FROM album_tracks");
+  while (query.next())
+    albums[query.value(0).toInt()].insert(query.value(1).toInt());
+  query.finish();
 
-    // Add file path and cover path from DB
-    track["filePath"] = query.value("file_path").toString();
-    track["coverPath"] = query.value("cover_path").toString();
+  QWriteLocker locker(&membershipLock);
+  favoriteIds = favorites;
+  albumTrackIds = albums;
+  qDebug() << "Database:" << favoriteIds.size() << "favorites in"
+           << albumTrackIds.size() << "albums";
+}
 
-    list.append(track);
-  }
+QList<Track> DatabaseManager::getFavorites() {
+  QList<Track> list;
+  forEachFavorite([&list](const Track &track) { list.append(track); });
   return list;
 }
 
-QJsonObject DatabaseManager::getTrack(int trackId) {
-  QSqlQuery query;
-  query.prepare(
-      "SELECT json_data, file_path, cover_path FROM favorites WHERE id = :id");
-  query.bindValue(":id", trackId);
+// Favorites in page order; the last two columns are the keyset key
+static const QString favoritesSelect =
+    "SELECT " + trackColumns + ", f.added_at, f.id FROM favorites f "
+    "WHERE f.is_favorite = 1 ";
+static const QString favoritesOrder = " ORDER BY f.added_at, f.id";
+static const QString favoritesPage =
+    favoritesSelect + "AND (f.added_at, f.id) > (:added_at, :key)" +
+    favoritesOrder + " LIMIT :limit";
 
-  if (query.exec() && query.next()) {
-    QString jsonStr = query.value("json_data").toString();
-    QJsonDocument doc = QJsonDocument::fromJson(jsonStr.toUtf8());
-    QJsonObject track = doc.object();
+void DatabaseManager::forEachFavorite(
+    const std::function<void(const Track &)> &fn) {
+  // Not cached: fn may use the database, even this same query
+  QSqlQuery query(database());
+  query.setForwardOnly(true);
+  if (!query.exec(favoritesSelect + favoritesOrder)) {
+    qDebug() << "forEachFavorite error:" << query.lastError();
+    return;
+  }
+  while (query.next())
+    fn(trackFromRow(query));
+}
 
-    // Add file path and cover path from DB
-    track["filePath"] = query.value("file_path").toString();
-    track["coverPath"] = query.value("cover_path").toString();
+TrackPage DatabaseManager::fetchFavorites(const TrackCursor &after,
+                                          int limit) {
+  QSqlQuery &query = cachedQuery(favoritesPage);
+  query.bindValue(":added_at", after.addedAt);
+  query.bindValue(":key", after.key);
+  query.bindValue(":limit", limit);
+  return readPage(query, after, limit);
+}
 
-    return track;
+QList<int> DatabaseManager::getFavoriteIds() {
+  QList<int> ids;
+  QSqlQuery &query = cachedQuery("SELECT f.id FROM favorites f "
+                                 "WHERE f.is_favorite = 1" +
+                                 favoritesOrder);
+  const auto reset = qScopeGuard([&query]() { query.finish(); });
+  if (!query.exec()) {
+    qDebug() << "getFavoriteIds error:" << query.lastError();
+    return ids;
   }
+  while (query.next())
+    ids.append(query.value(0).toInt());
+  return ids;
+}
 
-  return QJsonObject(); // Return empty object if not found
+// Collects a keyset page whose last two columns are (added_at, key)
+TrackPage DatabaseManager::readPage(QSqlQuery &query, const TrackCursor &after,
+                                    int limit) {
+  const auto reset = qScopeGuard([&query]() { query.finish(); });
+  TrackPage page;
+  page.next = after;
+  if (!query.exec()) {
+    qDebug() << "readPage error:" << query.lastError();
+    return page;
+  }
+  while (query.next()) {
+    page.tracks.append(trackFromRow(query));
+    page.next.addedAt = query.value(9).toLongLong();
+    page.next.key = query.value(10).toLongLong();
+  }
+  page.next.atEnd = page.tracks.size() < limit;
+  return page;
+}
+
+Track DatabaseManager::getTrack(int trackId) {
+  QSqlQuery &query = cachedQuery("SELECT " + trackColumns +
+                                 " FROM favorites f WHERE f.id = :id");
+  query.bindValue(":id", trackId);
+  const auto reset = qScopeGuard([&query]() { query.finish(); });
+
+  if (query.exec() && query.next())
+    return trackFromRow(query);
+
+  return Track(); // Return null track if not found
 }
 
 bool DatabaseManager::updateCoverPath(int trackId, const QString &coverPath) {
   qDebug() << "DB: updateCoverPath for" << trackId << "to" << coverPath;
-  QSqlQuery query;
-  query.prepare("UPDATE favorites SET cover_path = :path WHERE id = :id");
+  QSqlQuery &query =
+      cachedQuery("UPDATE favorites SET cover_path = :path WHERE id = :id");
   query.bindValue(":path", coverPath);
   query.bindValue(":id", trackId);
   bool success = query.exec();
@@ -259,27 +596,71 @@ bool DatabaseManager::updateCoverPath(int trackId, const QString &coverPath) {
 }
 
 bool DatabaseManager::updateFilePath(int trackId, const QString &filePath) {
-  QSqlQuery query;
-  query.prepare("UPDATE favorites SET file_path = :path WHERE id = :id");
+  QSqlQuery &query =
+      cachedQuery("UPDATE favorites SET file_path = :path WHERE id = :id");
   query.bindValue(":path", filePath);
   query.bindValue(":id", trackId);
   return query.exec();
 }
 
+bool DatabaseManager::updateFilePaths(const QHash<int, QString> &filePaths) {
+  QSqlDatabase db = database();
+  if (!db.transaction()) {
+    qDebug() << "updateFilePaths error:" << db.lastError();
+    return false;
+  }
+  QSqlQuery &query =
+      cachedQuery("UPDATE favorites SET file_path = :path WHERE id = :id");
+  for (auto it = filePaths.cbegin(); it != filePaths.cend(); ++it) {
+    query.bindValue(":path", it.value());
+    query.bindValue(":id", it.key());
+    if (!query.exec()) {
+      qDebug() << "updateFilePaths error:" << query.lastError();
+      db.rollback();
+      return false;
+    }
+  }
+  return db.commit();
+}
+
 QString DatabaseManager::getFilePath(int trackId) {
-  QSqlQuery query;
-  query.prepare("SELECT file_path FROM favorites WHERE id = :id");
+  QSqlQuery &query =
+      cachedQuery("SELECT file_path FROM favorites WHERE id = :id");
   query.bindValue(":id", trackId);
+  const auto reset = qScopeGuard([&query]() { query.finish(); });
   if (query.exec() && query.next()) {
     return query.value(0).toString();
   }
   return QString();
 }
 
+QHash<int, QString> DatabaseManager::getFilePaths(const QList<int> &trackIds) {
+  QHash<int, QString> paths;
+  for (qsizetype start = 0, rows; start < trackIds.size(); start += rows) {
+    rows = chunkRows(trackIds.size() - start);
+    const QList<int> chunk = trackIds.mid(start, rows);
+    QSqlQuery &query = cachedQuery(
+        "SELECT id, file_path FROM favorites WHERE file_path IS NOT NULL "
+        "AND file_path != '' AND id IN " +
+        placeholders(1, rows));
+    for (int trackId : chunk)
+      query.addBindValue(trackId);
+    if (!query.exec()) {
+      qDebug() << "getFilePaths error:" << query.lastError();
+      continue;
+    }
+    while (query.next())
+      paths.insert(query.value(0).toInt(), query.value(1).toString());
+    query.finish();
+  }
+  return paths;
+}
+
 QString DatabaseManager::getCoverPath(int trackId) {
-  QSqlQuery query;
-  query.prepare("SELECT cover_path FROM favorites WHERE id = :id");
+  QSqlQuery &query =
+      cachedQuery("SELECT cover_path FROM favorites WHERE id = :id");
   query.bindValue(":id", trackId);
+  const auto reset = qScopeGuard([&query]() { query.finish(); });
   if (query.exec() && query.next()) {
     QString path = query.value(0).toString();
     qDebug() << "DB: getCoverPath for" << trackId << "returned" << path;
@@ -291,13 +672,16 @@ QString DatabaseManager::getCoverPath(int trackId) {
 }
 
 int DatabaseManager::createAlbum(const QString &name,
-                                 const QString &coverPath) {
-  QSqlQuery query;
-  query.prepare("INSERT INTO albums (name, cover_path, created_at) VALUES "
-                "(:name, :cover_path, :created_at)");
+                                 const QString &coverPath,
+                                 int sourceAlbumId) {
+  QSqlQuery &query = cachedQuery(
+      "INSERT INTO albums (name, cover_path, created_at, source_album_id) "
+      "VALUES (:name, :cover_path, :created_at, :source_album_id)");
   query.bindValue(":name", name);
   query.bindValue(":cover_path", coverPath);
   query.bindValue(":created_at", QDateTime::currentSecsSinceEpoch());
+  query.bindValue(":source_album_id",
+                  sourceAlbumId > 0 ? QVariant(sourceAlbumId) : QVariant());
 
   if (query.exec()) {
     return query.lastInsertId().toInt();
@@ -306,143 +690,415 @@ int DatabaseManager::createAlbum(const QString &name,
   return -1;
 }
 
-QList<QJsonObject> DatabaseManager::getAlbums() {
-  QList<QJsonObject> list;
+int DatabaseManager::getAlbumBySource(int sourceAlbumId) {
+  QSqlQuery &query = cachedQuery(
+      "SELECT id FROM albums WHERE source_album_id = :source_album_id");
+  query.bindValue(":source_album_id", sourceAlbumId);
+  const auto reset = qScopeGuard([&query]() { query.finish(); });
+  if (query.exec() && query.next())
+    return query.value(0).toInt();
+  return -1;
+}
+
+QList<Album> DatabaseManager::getAlbums() {
+  QList<Album> list;
   QSqlQuery query("SELECT id, name, cover_id, cover_path FROM albums ORDER BY "
-                  "created_at DESC");
+                  "created_at DESC", database());
   while (query.next()) {
-    QJsonObject album;
-    album["id"] = query.value(0).toInt();
-    album["title"] = query.value(1).toString();
-
-    // Construct a minimal album object compatible with our UI
-    QJsonObject artistObj;
-    artistObj["name"] = "User Album"; // Placeholder
-    album["artist"] = artistObj;
-
-    // If cover_id is set, use it. Otherwise we might need to fetch it from
-    // first track later. For now, let's leave it empty or use a placeholder if
-    // null.
-    QString coverId = query.value(2).toString();
-    QString coverPath = query.value(3).toString();
-
-    if (!coverPath.isEmpty()) {
-      album["coverPath"] = coverPath;
-    }
-    if (!coverId.isEmpty()) {
-      album["cover"] = coverId;
-    }
+    Album album;
+    album.id = query.value(0).toInt();
+    album.title = query.value(1).toString();
+    album.artistName = "User Album"; // Placeholder
+
+    // cover_id may still be empty; the UI then composes one from the tracks
+    album.cover = query.value(2).toString();
+    album.coverPath = query.value(3).toString();
 
     list.append(album);
   }
   return list;
 }
 
-bool DatabaseManager::addTrackToAlbum(int albumId, const QJsonObject &track) {
-  int trackId = track["id"].toInt();
-
-  // Ensure track is in favorites database (so we can display it later)
-  // But don't force it to be a favorite if it isn't one.
-  // We just need it in the table.
-
-  QSqlQuery check;
-  check.prepare("SELECT id FROM favorites WHERE id = :id");
-  check.bindValue(":id", trackId);
-  if (!check.exec() || !check.next()) {
-    // Not in DB, insert it with is_favorite = 0
-    QSqlQuery insert;
-    insert.prepare(
-        "INSERT INTO favorites (id, title, artist, album, cover_id, json_data, "
-        "is_favorite) "
-        "VALUES (:id, :title, :artist, :album, :cover_id, :json_data, 0)");
-
-    QString title = track["title"].toString();
-    QString artist = track["artist"].toObject()["name"].toString();
-    QString album = track["album"].toObject()["title"].toString();
-    QString coverId = track["album"].toObject()["cover"].toString();
-    QString jsonData = QJsonDocument(track).toJson(QJsonDocument::Compact);
-
-    insert.bindValue(":id", trackId);
-    insert.bindValue(":title", title);
-    insert.bindValue(":artist", artist);
-    insert.bindValue(":album", album);
-    insert.bindValue(":cover_id", coverId);
-    insert.bindValue(":json_data", jsonData);
-    insert.exec();
-  }
-  // If it is in DB, we leave is_favorite as is.
-
-  // Check if album has a cover, if not, use this track's cover
-  QSqlQuery checkCover;
-  checkCover.prepare("SELECT cover_id FROM albums WHERE id = :album_id");
-  checkCover.bindValue(":album_id", albumId);
-  if (checkCover.exec() && checkCover.next()) {
-    QString currentCover = checkCover.value(0).toString();
-    if (currentCover.isEmpty()) {
-      // Set album cover to this track's cover
-      QString trackCover = track["album"].toObject()["cover"].toString();
-      if (!trackCover.isEmpty()) {
-        QSqlQuery updateCover;
-        updateCover.prepare(
-            "UPDATE albums SET cover_id = :cover WHERE id = :album_id");
-        updateCover.bindValue(":cover", trackCover);
-        updateCover.bindValue(":album_id", albumId);
-        updateCover.exec();
-      }
+bool DatabaseManager::addTrackToAlbum(int albumId, const Track &track) {
+  return addTracksToAlbum(albumId, {track});
+}
+
+bool DatabaseManager::addTracksToAlbum(int albumId,
+                                       const QList<Track> &tracks) {
+  QSqlDatabase db = database();
+  if (!db.transaction()) {
+    qDebug() << "addTracksToAlbum error:" << db.lastError();
+    return false;
+  }
+  auto fail = [&db](const QSqlQuery &query) {
+    qDebug() << "addTracksToAlbum error:" << query.lastError();
+    db.rollback();
+    return false;
+  };
+
+  // Album tracks need a row to be listed; favorites stay favorites
+  if (!insertTracks(tracks, false)) {
+    db.rollback();
+    return false;
+  }
+
+  // An album without a cover takes the first track's
+  QString coverId;
+  for (const Track &track : tracks) {
+    if (!track.cover().isEmpty()) {
+      coverId = track.cover();
+      break;
     }
   }
+  if (!coverId.isEmpty()) {
+    QSqlQuery &updateCover = cachedQuery(
+        "UPDATE albums SET cover_id = :cover WHERE id = :album_id "
+        "AND (cover_id IS NULL OR cover_id = '')");
+    updateCover.bindValue(":cover", coverId);
+    updateCover.bindValue(":album_id", albumId);
+    if (!updateCover.exec())
+      return fail(updateCover);
+  }
 
-  QSqlQuery query;
-  query.prepare(
-      "INSERT OR IGNORE INTO album_tracks (album_id, track_id, added_at) "
-      "VALUES (:album_id, :track_id, :added_at)");
-  query.bindValue(":album_id", albumId);
-  query.bindValue(":track_id", trackId);
-  query.bindValue(":added_at", QDateTime::currentSecsSinceEpoch());
+  qint64 now = QDateTime::currentSecsSinceEpoch();
+  for (qsizetype start = 0, rows; start < tracks.size(); start += rows) {
+    rows = chunkRows(tracks.size() - start);
+    const QList<Track> chunk = tracks.mid(start, rows);
+    QSqlQuery &link = cachedQuery(
+        "INSERT INTO album_tracks (album_id, track_id, added_at) VALUES " +
+        placeholders(rows, 3) + " ON CONFLICT DO NOTHING");
+    for (const Track &track : chunk) {
+      link.addBindValue(albumId);
+      link.addBindValue(track.id());
+      link.addBindValue(now);
+    }
+    if (!link.exec())
+      return fail(link);
+  }
+  if (!db.commit())
+    return false;
 
-  return query.exec();
+  QWriteLocker locker(&membershipLock);
+  QSet<int> &members = albumTrackIds[albumId];
+  for (const Track &track : tracks)
+    members.insert(track.id());
+  return true;
+}
+
+QList<Track> DatabaseManager::getAlbumTracks(int albumId) {
+  QList<Track> list;
+  forEachAlbumTrack(albumId,
+                    [&list](const Track &track) { list.append(track); });
+  return list;
 }
 
-QList<QJsonObject> DatabaseManager::getAlbumTracks(int albumId) {
-  QList<QJsonObject> list;
-  QSqlQuery query;
-  // Join with favorites to get track data.
-  // This assumes tracks in albums MUST be in favorites table.
-  // If we want to support non-favorites in albums, we'd need a separate
-  // 'tracks' table that is a superset of favorites. For simplicity, let's
-  // assume we only show tracks that are in our favorites cache.
-  query.prepare("SELECT f.json_data FROM favorites f "
-                "JOIN album_tracks at ON f.id = at.track_id "
-                "WHERE at.album_id = :album_id "
-                "ORDER BY at.added_at ASC");
+// Tracks of :album_id in the order they were added. Album tracks must be in
+// the favorites table, which caches every track we know of.
+static const QString albumTracksSelect =
+    "SELECT " + trackColumns + ", at.added_at, at.rowid FROM favorites f "
+    "JOIN album_tracks at ON f.id = at.track_id "
+    "WHERE at.album_id = :album_id ";
+static const QString albumTracksOrder = " ORDER BY at.added_at, at.rowid";
+
+void DatabaseManager::forEachAlbumTrack(
+    int albumId, const std::function<void(const Track &)> &fn) {
+  QSqlQuery query(database());
+  query.setForwardOnly(true);
+  query.prepare(albumTracksSelect + albumTracksOrder);
   query.bindValue(":album_id", albumId);
+  if (!query.exec()) {
+    qDebug() << "forEachAlbumTrack error:" << query.lastError();
+    return;
+  }
+  while (query.next())
+    fn(trackFromRow(query));
+}
 
-  if (query.exec()) {
-    while (query.next()) {
-      QString jsonStr = query.value(0).toString();
-      QJsonDocument doc = QJsonDocument::fromJson(jsonStr.toUtf8());
-      list.append(doc.object());
-    }
+QHash<int, QStringList> DatabaseManager::getAlbumCoverIds(int perAlbum) {
+  QHash<int, QStringList> covers;
+  QSqlQuery &query = cachedQuery(
+      "SELECT album_id, cover_id FROM (SELECT at.album_id, f.cover_id, "
+      "ROW_NUMBER() OVER (PARTITION BY at.album_id "
+      "ORDER BY at.added_at, at.rowid) AS n "
+      "FROM album_tracks at JOIN favorites f ON f.id = at.track_id "
+      "JOIN covers c ON c.cover_id = f.cover_id) "
+      "WHERE n <= :per_album ORDER BY album_id, n");
+  query.bindValue(":per_album", perAlbum);
+  const auto reset = qScopeGuard([&query]() { query.finish(); });
+  if (!query.exec()) {
+    qDebug() << "getAlbumCoverIds error:" << query.lastError();
+    return covers;
   }
-  return list;
+  while (query.next())
+    covers[query.value(0).toInt()].append(query.value(1).toString());
+  return covers;
 }
 
 bool DatabaseManager::deleteAlbum(int albumId) {
+  QSqlDatabase db = database();
+  if (!db.transaction()) {
+    qDebug() << "deleteAlbum error:" << db.lastError();
+    return false;
+  }
+  auto fail = [&db](const QSqlQuery &query) {
+    qDebug() << "deleteAlbum error:" << query.lastError();
+    db.rollback();
+    return false;
+  };
+
   // First delete all track associations
-  QSqlQuery deleteTracksQuery;
-  deleteTracksQuery.prepare(
-      "DELETE FROM album_tracks WHERE album_id = :album_id");
+  QSqlQuery &deleteTracksQuery =
+      cachedQuery("DELETE FROM album_tracks WHERE album_id = :album_id");
   deleteTracksQuery.bindValue(":album_id", albumId);
-  deleteTracksQuery.exec();
+  if (!deleteTracksQuery.exec())
+    return fail(deleteTracksQuery);
 
   // Then delete the album itself
-  QSqlQuery deleteAlbumQuery;
-  deleteAlbumQuery.prepare("DELETE FROM albums WHERE id = :id");
+  QSqlQuery &deleteAlbumQuery =
+      cachedQuery("DELETE FROM albums WHERE id = :id");
   deleteAlbumQuery.bindValue(":id", albumId);
+  if (!deleteAlbumQuery.exec())
+    return fail(deleteAlbumQuery);
+  if (!db.commit())
+    return false;
+
+  QWriteLocker locker(&membershipLock);
+  albumTrackIds.remove(albumId);
+  return true;
+}
+
+bool DatabaseManager::saveDownload(const QueuedDownload &download) {
+  QSqlQuery &query = cachedQuery(
+      "INSERT OR REPLACE INTO download_queue (track_id, url, state, "
+      "bytes_done, total_bytes, etag, last_modified, retry_count, "
+      "updated_at) VALUES (:track_id, :url, :state, :bytes_done, "
+      ":total_bytes, :etag, :last_modified, :retry_count, :updated_at)");
+  query.bindValue(":track_id", download.trackId);
+  query.bindValue(":url", download.url);
+  query.bindValue(":state", download.state);
+  query.bindValue(":bytes_done", download.bytesDone);
+  query.bindValue(":total_bytes", download.totalBytes);
+  query.bindValue(":etag", download.etag);
+  query.bindValue(":last_modified", download.lastModified);
+  query.bindValue(":retry_count", download.retryCount);
+  query.bindValue(":updated_at", QDateTime::currentSecsSinceEpoch());
+
+  if (!query.exec()) {
+    qDebug() << "saveDownload error:" << query.lastError();
+    return false;
+  }
+  return true;
+}
+
+bool DatabaseManager::removeDownload(int trackId) {
+  QSqlQuery &query =
+      cachedQuery("DELETE FROM download_queue WHERE track_id = :track_id");
+  query.bindValue(":track_id", trackId);
+
+  if (!query.exec()) {
+    qDebug() << "removeDownload error:" << query.lastError();
+    return false;
+  }
+  return true;
+}
+
+QList<QueuedDownload> DatabaseManager::getQueuedDownloads() {
+  QList<QueuedDownload> downloads;
+  QSqlQuery query("SELECT track_id, url, state, bytes_done, total_bytes, "
+                  "etag, last_modified, retry_count FROM download_queue "
+                  "ORDER BY updated_at", database());
+  while (query.next()) {
+    QueuedDownload download;
+    download.trackId = query.value(0).toInt();
+    download.url = query.value(1).toString();
+    download.state = query.value(2).toString();
+    download.bytesDone = query.value(3).toLongLong();
+    download.totalBytes = query.value(4).toLongLong();
+    download.etag = query.value(5).toString();
+    download.lastModified = query.value(6).toString();
+    download.retryCount = query.value(7).toInt();
+    downloads.append(download);
+  }
+  return downloads;
+}
 
-  if (!deleteAlbumQuery.exec()) {
-    qDebug() << "deleteAlbum error:" << deleteAlbumQuery.lastError();
+QString DatabaseManager::coverStorePath(const QString &coverId, int pixels) {
+  QDir dir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+  if (!dir.exists("covers"))
+    dir.mkpath("covers");
+  if (pixels > 0)
+    return dir.filePath(QString("covers/%1_%2.jpg").arg(coverId).arg(pixels));
+  return dir.filePath("covers/" + coverId + ".jpg");
+}
+
+bool DatabaseManager::storeCover(const QString &coverId,
+                                 const QString &filePath) {
+  // The first file recorded stays: every size of a cover is removed
+  // together, so it exists as long as the row does, and the path does not
+  // change with each size stored
+  QSqlQuery &query = cachedQuery(
+      "INSERT INTO covers (cover_id, file_path, created_at) "
+      "VALUES (:cover_id, :file_path, :created_at) ON CONFLICT DO NOTHING");
+  query.bindValue(":cover_id", coverId);
+  query.bindValue(":file_path", filePath);
+  query.bindValue(":created_at", QDateTime::currentSecsSinceEpoch());
+  if (!query.exec()) {
+    qDebug() << "storeCover error:" << query.lastError();
+    return false;
+  }
+
+  // Every track of the album shares the one file
+  QSqlQuery &update = cachedQuery(
+      "UPDATE favorites SET cover_path = (SELECT file_path FROM covers "
+      "WHERE cover_id = :stored_id) WHERE cover_id = :cover_id");
+  update.bindValue(":stored_id", coverId);
+  update.bindValue(":cover_id", coverId);
+  if (!update.exec()) {
+    qDebug() << "storeCover error:" << update.lastError();
+    return false;
+  }
+  return true;
+}
+
+int DatabaseManager::pruneCovers() {
+  // Covers no favorite, album track or album refers to, in one pass
+  QSqlQuery select("SELECT c.cover_id FROM covers c "
+                   "WHERE NOT EXISTS (SELECT 1 FROM favorites f "
+                   "WHERE f.cover_id = c.cover_id AND (f.is_favorite = 1 OR "
+                   "EXISTS (SELECT 1 FROM album_tracks at "
+                   "WHERE at.track_id = f.id))) "
+                   "AND NOT EXISTS (SELECT 1 FROM albums a "
+                   "WHERE a.cover_id = c.cover_id "
+                   "OR a.cover_path = c.file_path)",
+                   database());
+  QDir dir = QFileInfo(coverStorePath(QString())).dir();
+  QStringList unused;
+  while (select.next()) {
+    QString coverId = select.value(0).toString();
+    // The original and every thumbnail size
+    const QStringList files =
+        dir.entryList({coverId + ".jpg", coverId + "_*.jpg"}, QDir::Files);
+    for (const QString &file : files)
+      dir.remove(file);
+    unused.append(coverId);
+  }
+
+  for (const QString &coverId : unused)
+    forgetCover(coverId);
+  if (!unused.isEmpty())
+    qDebug() << "Pruned" << unused.size() << "unused covers";
+  return unused.size();
+}
+
+bool DatabaseManager::isCoverStored(const QString &coverId) {
+  QSqlQuery &query =
+      cachedQuery("SELECT 1 FROM covers WHERE cover_id = :cover_id");
+  query.bindValue(":cover_id", coverId);
+  const auto reset = qScopeGuard([&query]() { query.finish(); });
+  return query.exec() && query.next();
+}
+
+bool DatabaseManager::forgetCover(const QString &coverId) {
+  QSqlQuery &remove =
+      cachedQuery("DELETE FROM covers WHERE cover_id = :cover_id");
+  remove.bindValue(":cover_id", coverId);
+  if (!remove.exec()) {
+    qDebug() << "forgetCover error:" << remove.lastError();
+    return false;
+  }
+
+  QSqlQuery &clear = cachedQuery(
+      "UPDATE favorites SET cover_path = NULL WHERE cover_id = :cover_id");
+  clear.bindValue(":cover_id", coverId);
+  return clear.exec();
+}
+
+bool DatabaseManager::recordPlay(int trackId) {
+  QSqlQuery &query =
+      cachedQuery("UPDATE favorites SET last_played_at = :now, "
+                  "play_count = COALESCE(play_count, 0) + 1 WHERE id = :id");
+  query.bindValue(":now", QDateTime::currentSecsSinceEpoch());
+  query.bindValue(":id", trackId);
+  if (!query.exec()) {
+    qDebug() << "recordPlay error:" << query.lastError();
     return false;
   }
   return true;
 }
+
+QList<StoredDownload> DatabaseManager::getDownloadsByValue() {
+  QList<StoredDownload> list;
+  QSqlQuery query("SELECT f.id, f.file_path, f.is_favorite, EXISTS ("
+                  "SELECT 1 FROM album_tracks at WHERE at.track_id = f.id) "
+                  "FROM favorites f "
+                  "WHERE f.file_path IS NOT NULL AND f.file_path != '' "
+                  "ORDER BY f.is_favorite ASC, "
+                  "COALESCE(f.last_played_at, 0) + "
+                  "COALESCE(f.play_count, 0) * 604800 ASC",
+                  database());
+  while (query.next()) {
+    StoredDownload download;
+    download.trackId = query.value(0).toInt();
+    download.filePath = query.value(1).toString();
+    download.favorite = query.value(2).toBool();
+    download.pinned = query.value(3).toBool();
+    list.append(download);
+  }
+  return list;
+}
+
+QStringList DatabaseManager::getCoversByValue() {
+  QStringList list;
+  QSqlQuery query("SELECT c.cover_id FROM covers c "
+                  "LEFT JOIN favorites f ON f.cover_id = c.cover_id "
+                  "GROUP BY c.cover_id "
+                  "ORDER BY MAX(COALESCE(f.is_favorite, 0)) ASC, "
+                  "MAX(COALESCE(f.last_played_at, 0)) + "
+                  "SUM(COALESCE(f.play_count, 0)) * 604800 ASC", database());
+  while (query.next())
+    list.append(query.value(0).toString());
+  return list;
+}
+
+QFuture<bool> DatabaseManager::addFavoriteAsync(const Track &track) {
+  return write([this, track]() { return addFavorite(track); });
+}
+
+QFuture<bool> DatabaseManager::removeFavoriteAsync(int trackId) {
+  return write([this, trackId]() { return removeFavorite(trackId); });
+}
+
+QFuture<TrackPage>
+DatabaseManager::fetchFavoritesAsync(const TrackCursor &after, int limit) {
+  return read([this, after, limit]() { return fetchFavorites(after, limit); });
+}
+
+QFuture<bool> DatabaseManager::addTrackToAlbumAsync(int albumId,
+                                                    const Track &track) {
+  return write(
+      [this, albumId, track]() { return addTrackToAlbum(albumId, track); });
+}
+
+QFuture<QList<Track>> DatabaseManager::getAlbumTracksAsync(int albumId) {
+  return read([this, albumId]() { return getAlbumTracks(albumId); });
+}
+
+QFuture<bool> DatabaseManager::addTracksToAlbumAsync(
+    int albumId, const QList<Track> &tracks) {
+  return write(
+      [this, albumId, tracks]() { return addTracksToAlbum(albumId, tracks); });
+}
+
+QFuture<int> DatabaseManager::createAlbumAsync(const QString &name,
+                                               const QString &coverPath) {
+  return write(
+      [this, name, coverPath]() { return createAlbum(name, coverPath); });
+}
+
+QFuture<bool> DatabaseManager::deleteAlbumAsync(int albumId) {
+  return write([this, albumId]() { return deleteAlbum(albumId); });
+}
+
+QFuture<bool> DatabaseManager::recordPlayAsync(int trackId) {
+  return write([this, trackId]() { return recordPlay(trackId); });
+}
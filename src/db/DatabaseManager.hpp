@@ -1,33 +1,164 @@
 #pragma once
 
-#include <QJsonObject>
+#include "../model/Track.hpp"
+#include <QFuture>
+#include <QHash>
 #include <QList>
 #include <QObject>
+#include <QPair>
+#include <QPromise>
+#include <QReadWriteLock>
+#include <QSet>
 #include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QThread>
+#include <QThreadPool>
+#include <QThreadStorage>
 
+#include <functional>
+#include <memory>
+#include <type_traits>
+
+// A track download that has not completed yet, kept so it can resume with
+// a Range request after a restart or a dropped connection
+struct QueuedDownload {
+  int trackId = 0;
+  QString url;
+  QString state; // "active", "paused", "expired" or "failed"
+  qint64 bytesDone = 0;
+  qint64 totalBytes = 0;
+  QString etag;
+  QString lastModified;
+  int retryCount = 0;
+};
+
+// Where a keyset page ended. Rows come in (added_at, key) order and a page
+// starts after the last row of the previous one, so a deep page costs an
+// index seek rather than skipping every row before it.
+struct TrackCursor {
+  qint64 addedAt = -1; // Before every row
+  qint64 key = -1;     // Track id
+  bool atEnd = false;  // Nothing follows the page that returned it
+};
+
+struct TrackPage {
+  QList<Track> tracks;
+  TrackCursor next; // Pass back for the page after this one
+};
+
+// A track file on disk, as storage eviction sees it
+struct StoredDownload {
+  int trackId = 0;
+  QString filePath;
+  bool favorite = false;
+  bool pinned = false; // In an album, so kept offline whatever the quota
+};
+
+// Every method may be called from any thread and runs on that thread's own
+// connection. The async API runs them off the GUI thread instead: writes on
+// a DB thread that serializes them, reads on a small pool of connections
+// that WAL lets run alongside it.
 class DatabaseManager : public QObject {
   Q_OBJECT
 
 public:
   static DatabaseManager &instance();
 
-  bool addFavorite(const QJsonObject &track);
+  // Run fn() on the writer thread or a pooled reader and resolve with its
+  // result. Chain .then(context, ...) to receive it on context's thread.
+  // A read queued after a write may run first; chain it on the write.
+  template <typename Fn> auto write(Fn fn) { return run(writerContext, fn); }
+  template <typename Fn> auto read(Fn fn) { return run(nullptr, fn); }
+
+  QFuture<bool> addFavoriteAsync(const Track &track);
+  QFuture<bool> removeFavoriteAsync(int trackId);
+  QFuture<TrackPage> fetchFavoritesAsync(const TrackCursor &after, int limit);
+  QFuture<bool> addTrackToAlbumAsync(int albumId, const Track &track);
+  QFuture<bool> addTracksToAlbumAsync(int albumId,
+                                      const QList<Track> &tracks);
+  QFuture<QList<Track>> getAlbumTracksAsync(int albumId);
+  QFuture<int> createAlbumAsync(const QString &name,
+                                const QString &coverPath = QString());
+  QFuture<bool> deleteAlbumAsync(int albumId);
+  QFuture<bool> recordPlayAsync(int trackId);
+
+  bool addFavorite(const Track &track);
+  // Bulk variants write every row in one transaction with multi-row
+  // upserts, so a thousand tracks cost one commit
+  bool addFavorites(const QList<Track> &tracks);
   bool removeFavorite(int trackId);
-  bool isFavorite(int trackId);
-  QList<QJsonObject> getFavorites();
-  QJsonObject getTrack(int trackId);
+  // Answered from memory, so views may ask for every row they show
+  bool isFavorite(int trackId) const;
+  QList<Track> getFavorites();
+  // Hands each favorite to fn as it is read, in page order, without
+  // building the whole list
+  void forEachFavorite(const std::function<void(const Track &)> &fn);
+  // Up to limit favorites after the cursor; a default cursor starts at the
+  // first one
+  TrackPage fetchFavorites(const TrackCursor &after, int limit);
+  // Every favorite's id in page order, read from the index alone
+  QList<int> getFavoriteIds();
+  Track getTrack(int trackId);
   bool updateFilePath(int trackId, const QString &filePath);
+  // Many tracks in one transaction; all or none are written
+  bool updateFilePaths(const QHash<int, QString> &filePaths);
   bool updateCoverPath(int trackId, const QString &coverPath);
   QString getFilePath(int trackId);
+  // Downloaded tracks among trackIds; the others are left out
+  QHash<int, QString> getFilePaths(const QList<int> &trackIds);
   QString getCoverPath(int trackId);
+  // Feeds storage eviction: last_played_at and play_count
+  bool recordPlay(int trackId);
 
   // Album methods
-  int createAlbum(const QString &name, const QString &coverPath = QString());
-  QList<QJsonObject> getAlbums();
-  bool addTrackToAlbum(int albumId, const QJsonObject &track);
-  QList<QJsonObject> getAlbumTracks(int albumId);
+  // sourceAlbumId is the Tidal album a saved copy is made from, if any
+  int createAlbum(const QString &name, const QString &coverPath = QString(),
+                  int sourceAlbumId = 0);
+  // The album made from a Tidal album, or -1 if there is none yet
+  int getAlbumBySource(int sourceAlbumId);
+  QList<Album> getAlbums();
+  bool addTrackToAlbum(int albumId, const Track &track);
+  bool addTracksToAlbum(int albumId, const QList<Track> &tracks);
+  QList<Track> getAlbumTracks(int albumId);
+  // Stored cover UUIDs of each album's first perAlbum tracks that have one,
+  // in album order, for every album at once
+  QHash<int, QStringList> getAlbumCoverIds(int perAlbum);
+  // Albums holding the track, answered from memory like isFavorite()
+  QList<int> albumsWithTrack(int trackId) const;
+  void forEachAlbumTrack(int albumId,
+                         const std::function<void(const Track &)> &fn);
   bool deleteAlbum(int albumId);
 
+  // Download queue
+  bool saveDownload(const QueuedDownload &download);
+  bool removeDownload(int trackId);
+  QList<QueuedDownload> getQueuedDownloads();
+
+  // Cover store: one file per Tidal cover UUID, shared by every track and
+  // album using it, and kept while any favorite or album refers to it
+  // pixels > 0 names the thumbnail of that square size; 0 the original
+  static QString coverStorePath(const QString &coverId, int pixels = 0);
+  // Records that filePath, one size of the cover, is in the store. Its
+  // rows' cover_path then names the first file recorded.
+  bool storeCover(const QString &coverId, const QString &filePath);
+  bool isCoverStored(const QString &coverId);
+  // Deletes stored covers nothing refers to any more; returns how many.
+  // Storage compaction runs it, so unfavoriting stays a single update.
+  int pruneCovers();
+  // Drops a cover's row once its files are gone
+  bool forgetCover(const QString &coverId);
+
+  // Every downloaded track in storage eviction order, least valuable
+  // first: other tracks before favorites, then by the last play plus a week
+  // per play
+  QList<StoredDownload> getDownloadsByValue();
+  // Covers no favorite or album refers to come first
+  QStringList getCoversByValue();
+
+  // The calling thread's connection, opened on first use
+  QSqlDatabase database();
+
 private:
   explicit DatabaseManager(QObject *parent = nullptr);
   ~DatabaseManager();
@@ -35,5 +166,66 @@ private:
   DatabaseManager &operator=(const DatabaseManager &) = delete;
 
   void initDatabase();
-  QSqlDatabase m_db;
+  void loadMembership();
+  void migrate();
+  bool migrateTo(int version);
+  void migrateCoverStore();
+  void moveCovers();
+  // Old and new path of each cover file the running step relocates
+  QList<QPair<QString, QString>> coverMoves;
+  void migrateTrackColumns();
+  // Builds a Track from the columns listed in trackColumns
+  static Track trackFromRow(const QSqlQuery &query);
+  static TrackPage readPage(QSqlQuery &query, const TrackCursor &after,
+                            int limit);
+  // Upserts rows for tracks; the caller holds the transaction
+  bool insertTracks(const QList<Track> &tracks, bool favorite);
+  QString dbPath;
+
+  // A QSqlDatabase handle may only be used on the thread that opened it
+  struct Connection {
+    QSqlDatabase db;
+    QHash<QString, QSqlQuery *> statements;
+    ~Connection();
+  };
+  QThreadStorage<Connection *> connections;
+  Connection &connection();
+
+  // Favorite ids and album membership mirrored from the tables, so
+  // membership checks need no SQL. Written through after each commit.
+  mutable QReadWriteLock membershipLock;
+  QSet<int> favoriteIds;
+  QHash<int, QSet<int>> albumTrackIds; // Album id to its track ids
+
+  QThread *writerThread;
+  QObject *writerContext; // Lives on writerThread
+  QThreadPool *readPool;
+
+  // Runs fn on context's thread, or on the read pool if context is null
+  template <typename Fn> auto run(QObject *context, Fn fn) {
+    using Result = std::invoke_result_t<Fn>;
+    auto promise = std::make_shared<QPromise<Result>>();
+    QFuture<Result> future = promise->future();
+    promise->start();
+    auto task = [promise, fn]() {
+      if constexpr (std::is_void_v<Result>) {
+        fn();
+      } else {
+        promise->addResult(fn());
+      }
+      promise->finish();
+    };
+    if (context)
+      QMetaObject::invokeMethod(context, task);
+    else
+      readPool->start(task);
+    return future;
+  }
+
+  // Prepared statements of the calling thread's connection by SQL text,
+  // reused across calls. The returned query is reset and keeps its plan;
+  // bind and exec it before asking for the same SQL again. Reads that stop
+  // before the last row finish() it, or its open read transaction would
+  // hold back autocommits.
+  QSqlQuery &cachedQuery(const QString &sql);
 };
@@ -0,0 +1,274 @@
+#include "StorageManager.hpp"
+#include "DatabaseManager.hpp"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QThread>
+
+static const qint64 megabyte = 1024 * 1024;
+// By StorageClass
+static const qint64 defaultQuotas[] = {4096 * megabyte, 8192 * megabyte,
+                                       256 * megabyte, 1024 * megabyte};
+// Compaction waits this long after the last request for it
+static const int compactDelayMs = 10000;
+// Files this recent may belong to a write whose row is not saved yet
+static const qint64 orphanGraceSecs = 600;
+
+StorageManager::StorageManager(QObject *parent) : QObject(parent) {
+  QString dataPath =
+      QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+  settingsPath = QDir(dataPath).filePath("storage.ini");
+  QSettings settings(settingsPath, QSettings::IniFormat);
+  for (int i = Downloads; i <= Playback; ++i) {
+    quotas[i] = settings
+                    .value(settingsKey(StorageClass(i)),
+                           defaultQuotas[i] / megabyte)
+                    .toLongLong() *
+                megabyte;
+  }
+
+  compactTimer = new QTimer(this);
+  compactTimer->setSingleShot(true);
+  compactTimer->setInterval(compactDelayMs);
+  connect(compactTimer, &QTimer::timeout, this, &StorageManager::compact);
+}
+
+StorageManager::~StorageManager() {
+  if (worker) {
+    worker->wait();
+    delete worker;
+  }
+}
+
+qint64 StorageManager::quota(StorageClass storageClass) const {
+  return quotas[storageClass];
+}
+
+void StorageManager::setQuota(StorageClass storageClass, qint64 bytes) {
+  quotas[storageClass] = bytes;
+  QSettings settings(settingsPath, QSettings::IniFormat);
+  settings.setValue(settingsKey(storageClass), bytes / megabyte);
+  scheduleCompaction();
+}
+
+const char *StorageManager::settingsKey(StorageClass storageClass) {
+  switch (storageClass) {
+  case Downloads:
+    return "downloads_mb";
+  case Favorites:
+    return "favorites_mb";
+  case Covers:
+    return "covers_mb";
+  case Playback:
+    return "playback_mb";
+  }
+  return "";
+}
+
+void StorageManager::scheduleCompaction() { compactTimer->start(); }
+
+void StorageManager::compact() {
+  if (preparing || worker) {
+    scheduleCompaction(); // One at a time; try again after this one
+    return;
+  }
+
+  Job job;
+  job.dataPath =
+      QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+  job.downloadQuota = quotas[Downloads];
+  job.favoriteQuota = quotas[Favorites];
+  job.coverQuota = quotas[Covers];
+  job.playbackQuota = quotas[Playback];
+
+  // Unused covers are pruned and the rows read on the DB thread, so the
+  // read sees the writes queued before it; only files are touched on the
+  // worker
+  preparing = true;
+  DatabaseManager::instance()
+      .write([job]() {
+        DatabaseManager::instance().pruneCovers();
+        return prepareJob(job);
+      })
+      .then(this, [this](const Job &job) {
+        preparing = false;
+        worker = QThread::create([this, job]() {
+          Result result = runJob(job);
+          QMetaObject::invokeMethod(
+              this, [this, result]() { applyResult(result); });
+        });
+        worker->setObjectName("storage");
+        worker->start(QThread::LowPriority);
+      });
+}
+
+StorageManager::Job StorageManager::prepareJob(Job job) {
+  DatabaseManager &db = DatabaseManager::instance();
+  const QList<StoredDownload> tracks = db.getDownloadsByValue();
+  for (const StoredDownload &track : tracks) {
+    job.referencedFiles.append(track.filePath);
+    Candidate candidate{QString::number(track.trackId),
+                        QStringList{track.filePath}};
+    if (!track.favorite && !track.pinned) {
+      job.trackCandidates.append(candidate);
+      continue;
+    }
+    // Albums made available offline stay, even past the quota
+    job.favoriteFiles.append(track.filePath);
+    if (!track.pinned)
+      job.favoriteCandidates.append(candidate);
+  }
+  // Partial files of queued downloads are still wanted
+  const QList<QueuedDownload> queued = db.getQueuedDownloads();
+  for (const QueuedDownload &download : queued) {
+    job.referencedFiles.append(
+        QDir(job.dataPath).filePath("downloads/" +
+                                    QString::number(download.trackId) +
+                                    ".flac.part"));
+  }
+
+  job.knownCovers = db.getCoversByValue();
+  for (const QString &coverId : std::as_const(job.knownCovers))
+    job.coverCandidates.append({coverId, QStringList()});
+  return job;
+}
+
+StorageManager::Result StorageManager::runJob(const Job &job) {
+  Result result;
+  result.usage.downloadQuota = job.downloadQuota;
+  result.usage.favoriteQuota = job.favoriteQuota;
+  result.usage.coverQuota = job.coverQuota;
+  result.usage.playbackQuota = job.playbackQuota;
+  qint64 now = QDateTime::currentSecsSinceEpoch();
+  const QSet<QString> referenced(job.referencedFiles.cbegin(),
+                                 job.referencedFiles.cend());
+  const QSet<QString> favoriteFiles(job.favoriteFiles.cbegin(),
+                                    job.favoriteFiles.cend());
+  const QSet<QString> knownCovers(job.knownCovers.cbegin(),
+                                  job.knownCovers.cend());
+
+  // A file is an orphan if no row names it and it is not being written
+  auto isOrphan = [now](const QFileInfo &info, bool known) {
+    return !known && info.lastModified().toSecsSinceEpoch() <
+                         now - orphanGraceSecs;
+  };
+
+  QDir downloads(QDir(job.dataPath).filePath("downloads"));
+  QDirIterator downloadFiles(downloads.path(), QDir::Files);
+  while (downloadFiles.hasNext()) {
+    QFileInfo info(downloadFiles.next());
+    if (isOrphan(info, referenced.contains(info.filePath())) &&
+        QFile::remove(info.filePath())) {
+      result.usage.orphansRemoved++;
+      continue;
+    }
+    // Partial files count as downloads until they are kept
+    if (favoriteFiles.contains(info.filePath()))
+      result.usage.favoriteBytes += info.size();
+    else
+      result.usage.downloadBytes += info.size();
+  }
+
+  // Covers are grouped by UUID: the original and every thumbnail size
+  QDir covers(QDir(job.dataPath).filePath("covers"));
+  QHash<QString, QStringList> coverFiles;
+  QDirIterator coverIt(covers.path(), {"*.jpg"}, QDir::Files);
+  while (coverIt.hasNext()) {
+    QFileInfo info(coverIt.next());
+    QString coverId = info.completeBaseName().section('_', 0, 0);
+    if (isOrphan(info, knownCovers.contains(coverId)) &&
+        QFile::remove(info.filePath())) {
+      result.usage.orphansRemoved++;
+      continue;
+    }
+    coverFiles[coverId].append(info.filePath());
+    result.usage.coverBytes += info.size();
+  }
+
+  // Each class of tracks makes room within its own quota only
+  auto evictTracks = [&result](const QList<Candidate> &candidates,
+                               qint64 &bytes, qint64 quota) {
+    for (const Candidate &track : candidates) {
+      if (bytes <= quota)
+        break;
+      for (const QString &file : track.second) {
+        qint64 size = QFileInfo(file).size();
+        if (QFile::remove(file))
+          bytes -= size;
+      }
+      result.evictedTracks.append(track.first);
+    }
+  };
+  evictTracks(job.trackCandidates, result.usage.downloadBytes,
+              job.downloadQuota);
+  evictTracks(job.favoriteCandidates, result.usage.favoriteBytes,
+              job.favoriteQuota);
+
+  for (const Candidate &cover : job.coverCandidates) {
+    if (result.usage.coverBytes <= job.coverQuota)
+      break;
+    const QStringList files = coverFiles.value(cover.first);
+    for (const QString &file : files) {
+      qint64 size = QFileInfo(file).size();
+      if (QFile::remove(file))
+        result.usage.coverBytes -= size;
+    }
+    result.evictedCovers.append(cover.first);
+  }
+
+  // No rows refer to stream files; the oldest go first and the newest,
+  // which is playing, stays
+  QDir playback(QDir(job.dataPath).filePath("playback"));
+  const QFileInfoList streams =
+      playback.entryInfoList(QDir::Files, QDir::Time);
+  for (const QFileInfo &info : streams)
+    result.usage.playbackBytes += info.size();
+  int evictedStreams = 0;
+  for (qsizetype i = streams.size() - 1; i > 0; --i) {
+    if (result.usage.playbackBytes <= job.playbackQuota)
+      break;
+    if (QFile::remove(streams[i].filePath())) {
+      result.usage.playbackBytes -= streams[i].size();
+      evictedStreams++;
+    }
+  }
+
+  result.usage.evicted = result.evictedTracks.size() +
+                         result.evictedCovers.size() + evictedStreams;
+  return result;
+}
+
+void StorageManager::applyResult(const Result &result) {
+  worker->wait();
+  delete worker;
+  worker = nullptr;
+
+  if (!result.evictedTracks.isEmpty() || !result.evictedCovers.isEmpty()) {
+    DatabaseManager::instance().write([result]() {
+      DatabaseManager &db = DatabaseManager::instance();
+      for (const QString &trackId : result.evictedTracks)
+        db.updateFilePath(trackId.toInt(), QString());
+      for (const QString &coverId : result.evictedCovers)
+        db.forgetCover(coverId);
+    });
+  }
+
+  lastUsage = result.usage;
+  qDebug() << "Storage: downloads" << lastUsage.downloadBytes / megabyte
+           << "of" << lastUsage.downloadQuota / megabyte << "MB, favorites"
+           << lastUsage.favoriteBytes / megabyte << "of"
+           << lastUsage.favoriteQuota / megabyte << "MB, covers"
+           << lastUsage.coverBytes / megabyte << "of"
+           << lastUsage.coverQuota / megabyte << "MB, playback"
+           << lastUsage.playbackBytes / megabyte << "of"
+           << lastUsage.playbackQuota / megabyte << "MB, evicted"
+           << lastUsage.evicted << "and removed" << lastUsage.orphansRemoved
+           << "orphans";
+  emit usageChanged(lastUsage);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+class QThread;
+
+struct StorageUsage {
+  qint64 downloadBytes = 0;
+  qint64 downloadQuota = 0;
+  qint64 favoriteBytes = 0;
+  qint64 favoriteQuota = 0;
+  qint64 coverBytes = 0;
+  qint64 coverQuota = 0;
+  qint64 playbackBytes = 0;
+  qint64 playbackQuota = 0;
+  int evicted = 0;       // Tracks, covers and streams evicted last time
+  int orphansRemoved = 0; // Files nothing referred to
+};
+
+// Keeps what the app stores under AppDataLocation within a quota per class:
+// Downloads are track files nothing asked to keep, which are cheap to fetch
+// again; Favorites are the files of favorites and album tracks in
+// downloads/; Covers is covers/ and Playback the stream files AudioPlayer
+// writes to playback/. Quotas are read from storage.ini there
+// (downloads_mb, favorites_mb, covers_mb, playback_mb) so they can be set
+// per machine. Compaction first prunes covers no favorite or album uses any
+// more, then walks the directories on a worker thread: it removes files no
+// database row refers to, then evicts the least valuable entries until each
+// class fits. Value blends recency and frequency: the last play plus a week
+// per play. A class is only ever evicted to fit its own quota, and tracks
+// in an album are never evicted. Evicted tracks lose their file_path and
+// are fetched again when needed. Of the stream files, the newest one is
+// playing and stays.
+class StorageManager : public QObject {
+  Q_OBJECT
+
+public:
+  enum StorageClass { Downloads, Favorites, Covers, Playback };
+  Q_ENUM(StorageClass)
+
+  explicit StorageManager(QObject *parent = nullptr);
+  ~StorageManager();
+
+  qint64 quota(StorageClass storageClass) const;
+  void setQuota(StorageClass storageClass, qint64 bytes);
+  // As measured by the last compaction
+  StorageUsage usage() const { return lastUsage; }
+
+  // Compacts a little later, once a burst of downloads has settled
+  void scheduleCompaction();
+  void compact();
+
+signals:
+  void usageChanged(const StorageUsage &usage);
+
+private:
+  // Files to delete together, most expendable first; key is a track or
+  // cover id
+  using Candidate = QPair<QString, QStringList>;
+
+  struct Job {
+    QString dataPath;
+    qint64 downloadQuota = 0;
+    qint64 favoriteQuota = 0;
+    qint64 coverQuota = 0;
+    qint64 playbackQuota = 0;
+    QStringList referencedFiles; // Never treated as orphans
+    QStringList favoriteFiles;   // Counted against the Favorites quota
+    QStringList knownCovers;     // Cover UUIDs with a covers row
+    QList<Candidate> trackCandidates;
+    QList<Candidate> favoriteCandidates;
+    QList<Candidate> coverCandidates;
+  };
+
+  struct Result {
+    StorageUsage usage;
+    QStringList evictedTracks;
+    QStringList evictedCovers;
+  };
+
+  QTimer *compactTimer;
+  QThread *worker = nullptr;
+  bool preparing = false; // Reading the rows for the next job
+  qint64 quotas[Playback + 1];
+  QString settingsPath;
+  StorageUsage lastUsage;
+
+  // Fills in the rows the job works from; runs on the DB thread
+  static Job prepareJob(Job job);
+  static const char *settingsKey(StorageClass storageClass);
+  static Result runJob(const Job &job);
+  void applyResult(const Result &result);
+};
@@ -0,0 +1,282 @@
+#include "db/DatabaseManager.hpp"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSqlQuery>
+#include <QStandardPaths>
+
+#include <functional>
+
+static Track makeTrack(int id) {
+  Track track;
+  track.setId(id);
+  track.setTitle(QString("Track %1").arg(id));
+  track.setDuration(180 + id % 120);
+  track.setArtist(id % 50 + 1, QString("Artist %1").arg(id % 50));
+  track.setAlbum(QString("Album %1").arg(id % 200),
+                 QString("cover-%1").arg(id % 200));
+  return track;
+}
+
+static void run(const char *label, int iterations,
+                const std::function<void(int)> &operation) {
+  QElapsedTimer timer;
+  timer.start();
+  for (int i = 0; i < iterations; ++i)
+    operation(i);
+  qint64 ns = timer.nsecsElapsed();
+  qDebug().noquote() << QString("  %1 %2 us/op")
+                            .arg(QString::fromLatin1(label), -16)
+                            .arg(ns / 1000.0 / iterations, 0, 'f', 1);
+}
+
+// The original DatabaseManager, call for call: its schema, a prepare per
+// call, rows stored and read back as JSON text, a SELECT per isFavorite and
+// no transactions, on a connection with SQLite's defaults
+namespace baseline {
+
+static QString json(const Track &track) {
+  return QJsonDocument(track.toJson()).toJson(QJsonDocument::Compact);
+}
+
+static void createTables(QSqlDatabase db) {
+  QSqlQuery query(db);
+  query.exec("CREATE TABLE favorites (id INTEGER PRIMARY KEY, title TEXT, "
+             "artist TEXT, album TEXT, cover_id TEXT, file_path TEXT, "
+             "cover_path TEXT, json_data TEXT, "
+             "is_favorite INTEGER DEFAULT 1)");
+  query.exec("CREATE TABLE albums (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+             "name TEXT, cover_id TEXT, cover_path TEXT, "
+             "created_at INTEGER)");
+  query.exec("CREATE TABLE album_tracks (album_id INTEGER, "
+             "track_id INTEGER, added_at INTEGER, "
+             "PRIMARY KEY (album_id, track_id))");
+}
+
+// It looked the row up twice and prepared the write twice
+static void addFavorite(QSqlDatabase db, const Track &track) {
+  QSqlQuery check(db);
+  check.prepare("SELECT id FROM favorites WHERE id = :id");
+  check.bindValue(":id", track.id());
+  QSqlQuery query(db);
+  if (check.exec() && check.next())
+    query.prepare("UPDATE favorites SET is_favorite = 1, title = :title, "
+                  "artist = :artist, album = :album, cover_id = :cover_id, "
+                  "json_data = :json_data WHERE id = :id");
+  else
+    query.prepare("INSERT INTO favorites (id, title, artist, album, "
+                  "cover_id, json_data, cover_path, is_favorite) "
+                  "VALUES (:id, :title, :artist, :album, :cover_id, "
+                  ":json_data, :cover_path, 1)");
+  if (check.exec() && check.next()) {
+    query.prepare("UPDATE favorites SET is_favorite = 1, json_data = "
+                  ":json_data WHERE id = :id");
+    query.bindValue(":json_data", json(track));
+    query.bindValue(":id", track.id());
+  } else {
+    query.prepare("INSERT INTO favorites (id, title, artist, album, "
+                  "cover_id, json_data, cover_path, is_favorite) "
+                  "VALUES (:id, :title, :artist, :album, :cover_id, "
+                  ":json_data, :cover_path, 1)");
+    query.bindValue(":id", track.id());
+    query.bindValue(":title", track.title());
+    query.bindValue(":artist", track.artistName());
+    query.bindValue(":album", track.albumTitle());
+    query.bindValue(":cover_id", track.cover());
+    query.bindValue(":json_data", json(track));
+    query.bindValue(":cover_path", QString(""));
+  }
+  query.exec();
+}
+
+static bool isFavorite(QSqlDatabase db, int trackId) {
+  QSqlQuery query(db);
+  query.prepare("SELECT id FROM favorites WHERE id = :id AND is_favorite = 1");
+  query.bindValue(":id", trackId);
+  return query.exec() && query.next();
+}
+
+static QJsonObject rowTrack(const QSqlQuery &query) {
+  QJsonObject track =
+      QJsonDocument::fromJson(query.value(0).toString().toUtf8()).object();
+  track["filePath"] = query.value(1).toString();
+  track["coverPath"] = query.value(2).toString();
+  return track;
+}
+
+static QJsonObject getTrack(QSqlDatabase db, int trackId) {
+  QSqlQuery query(db);
+  query.prepare("SELECT json_data, file_path, cover_path FROM favorites "
+                "WHERE id = :id");
+  query.bindValue(":id", trackId);
+  if (query.exec() && query.next())
+    return rowTrack(query);
+  return QJsonObject();
+}
+
+static void updateFilePath(QSqlDatabase db, int trackId,
+                           const QString &filePath) {
+  QSqlQuery query(db);
+  query.prepare("UPDATE favorites SET file_path = :path WHERE id = :id");
+  query.bindValue(":path", filePath);
+  query.bindValue(":id", trackId);
+  query.exec();
+}
+
+static QList<QJsonObject> getFavorites(QSqlDatabase db) {
+  QList<QJsonObject> list;
+  QSqlQuery query("SELECT json_data, file_path, cover_path FROM favorites "
+                  "WHERE is_favorite = 1",
+                  db);
+  while (query.next())
+    list.append(rowTrack(query));
+  return list;
+}
+
+static int createAlbum(QSqlDatabase db, const QString &name) {
+  QSqlQuery query(db);
+  query.prepare("INSERT INTO albums (name, cover_path, created_at) VALUES "
+                "(:name, :cover_path, :created_at)");
+  query.bindValue(":name", name);
+  query.bindValue(":cover_path", QString());
+  query.bindValue(":created_at", QDateTime::currentSecsSinceEpoch());
+  return query.exec() ? query.lastInsertId().toInt() : -1;
+}
+
+static void addTrackToAlbum(QSqlDatabase db, int albumId,
+                            const Track &track) {
+  QSqlQuery check(db);
+  check.prepare("SELECT id FROM favorites WHERE id = :id");
+  check.bindValue(":id", track.id());
+  if (!check.exec() || !check.next()) {
+    QSqlQuery insert(db);
+    insert.prepare("INSERT INTO favorites (id, title, artist, album, "
+                   "cover_id, json_data, is_favorite) VALUES (:id, :title, "
+                   ":artist, :album, :cover_id, :json_data, 0)");
+    insert.bindValue(":id", track.id());
+    insert.bindValue(":title", track.title());
+    insert.bindValue(":artist", track.artistName());
+    insert.bindValue(":album", track.albumTitle());
+    insert.bindValue(":cover_id", track.cover());
+    insert.bindValue(":json_data", json(track));
+    insert.exec();
+  }
+
+  QSqlQuery checkCover(db);
+  checkCover.prepare("SELECT cover_id FROM albums WHERE id = :album_id");
+  checkCover.bindValue(":album_id", albumId);
+  if (checkCover.exec() && checkCover.next() &&
+      checkCover.value(0).toString().isEmpty() && !track.cover().isEmpty()) {
+    QSqlQuery updateCover(db);
+    updateCover.prepare(
+        "UPDATE albums SET cover_id = :cover WHERE id = :album_id");
+    updateCover.bindValue(":cover", track.cover());
+    updateCover.bindValue(":album_id", albumId);
+    updateCover.exec();
+  }
+
+  QSqlQuery query(db);
+  query.prepare("INSERT OR IGNORE INTO album_tracks (album_id, track_id, "
+                "added_at) VALUES (:album_id, :track_id, :added_at)");
+  query.bindValue(":album_id", albumId);
+  query.bindValue(":track_id", track.id());
+  query.bindValue(":added_at", QDateTime::currentSecsSinceEpoch());
+  query.exec();
+}
+
+// It had no download queue and no bulk or paged reads, so those rows only
+// appear in the current profile
+static void runProfile(QSqlDatabase db, int count) {
+  run("addFavorite", count,
+      [&](int i) { addFavorite(db, makeTrack(1 + i)); });
+  run("isFavorite", count * 4,
+      [&](int i) { isFavorite(db, 1 + i % count); });
+  run("getTrack", count, [&](int i) { getTrack(db, 1 + i); });
+  run("updateFilePath", count, [&](int i) {
+    updateFilePath(db, 1 + i, QString("/tmp/%1.flac").arg(i));
+  });
+  run("getFavorites", 10, [&](int) { getFavorites(db); });
+
+  int album = createAlbum(db, "per track");
+  run("addTrackToAlbum", count, [&](int i) {
+    addTrackToAlbum(db, album, makeTrack(1 + count * 2 + i));
+  });
+}
+
+} // namespace baseline
+
+// The same operations through DatabaseManager as it is now
+static void runProfile(int count) {
+  DatabaseManager &db = DatabaseManager::instance();
+  run("addFavorite", count, [&](int i) { db.addFavorite(makeTrack(1 + i)); });
+  run("isFavorite", count * 4, [&](int i) { db.isFavorite(1 + i % count); });
+  run("getTrack", count, [&](int i) { db.getTrack(1 + i); });
+  run("updateFilePath", count, [&](int i) {
+    db.updateFilePath(1 + i, QString("/tmp/%1.flac").arg(i));
+  });
+  run("saveDownload", count, [&](int i) {
+    QueuedDownload download;
+    download.trackId = 1 + i;
+    download.state = "active";
+    download.bytesDone = i * 4096;
+    db.saveDownload(download);
+  });
+  run("getFavorites", 10, [&](int) { db.getFavorites(); });
+  // Walking every favorite a page at a time; each page is an index seek
+  run("fetchFavorites", 10, [&](int) {
+    TrackCursor cursor;
+    while (!cursor.atEnd)
+      cursor = db.fetchFavorites(cursor, 50).next;
+  });
+
+  // Importing an album: one call per track against one bulk call
+  QList<Track> album;
+  for (int i = 0; i < count; ++i)
+    album.append(makeTrack(1 + count * 2 + i));
+  int perTrack = db.createAlbum("per track");
+  run("addTrackToAlbum", count,
+      [&](int i) { db.addTrackToAlbum(perTrack, album[i]); });
+  int bulk = db.createAlbum("bulk");
+  run("addTracksToAlbum", 1, [&](int) { db.addTracksToAlbum(bulk, album); });
+}
+
+// Usage: db_bench [-n rows]
+// Times each database operation as the original code ran it, then through
+// DatabaseManager as it is now, each on a fresh scratch database.
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  app.setApplicationName("db_bench");
+  QStringList args = app.arguments().mid(1);
+
+  int count = 2000;
+  if (args.size() >= 2 && args[0] == "-n")
+    count = qMax(1, args[1].toInt());
+
+  // Scratch databases, never the user's
+  QStandardPaths::setTestModeEnabled(true);
+  QDir dir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+  dir.removeRecursively();
+  dir.mkpath(".");
+
+  qDebug().noquote() << "baseline (original queries: JSON rows, a prepare "
+                        "per call, SQL isFavorite, no transactions; "
+                        "rollback journal, synchronous=FULL):";
+  {
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "baseline");
+    db.setDatabaseName(dir.filePath("baseline.db"));
+    db.open();
+    baseline::createTables(db);
+    baseline::runProfile(db, count);
+  }
+  QSqlDatabase::removeDatabase("baseline");
+
+  qDebug().noquote() << "current (typed columns, statement cache, in-memory "
+                        "isFavorite, bulk transactions; WAL, "
+                        "synchronous=NORMAL, mmap):";
+  runProfile(count);
+  return 0;
+}
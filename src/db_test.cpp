@@ -0,0 +1,184 @@
+#include "db/DatabaseManager.hpp"
+#include <QCborValue>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QRegularExpression>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStandardPaths>
+
+static int failures = 0;
+
+static void check(bool ok, const QString &what) {
+  if (ok)
+    return;
+  qDebug().noquote() << "FAIL:" << what;
+  failures++;
+}
+
+// A database as it was before versioning: JSON rows and per-track covers
+static void seedLegacyDatabase(const QString &dbPath,
+                               const QString &coverPath) {
+  {
+    QSqlDatabase seed = QSqlDatabase::addDatabase("QSQLITE", "seed");
+    seed.setDatabaseName(dbPath);
+    seed.open();
+    QSqlQuery query(seed);
+    query.exec("CREATE TABLE favorites (id INTEGER PRIMARY KEY, title TEXT, "
+               "artist TEXT, album TEXT, cover_id TEXT, file_path TEXT, "
+               "cover_path TEXT, json_data TEXT)");
+    query.prepare("INSERT INTO favorites (id, title, cover_id, cover_path, "
+                  "json_data) VALUES (42, 'Legacy', 'legacy-cover', ?, ?)");
+    query.addBindValue(coverPath);
+    query.addBindValue(QString(
+        "{\"id\":42,\"title\":\"Legacy\",\"duration\":200,"
+        "\"audioQuality\":\"LOSSLESS\",\"artist\":{\"id\":7,\"name\":\"A\"},"
+        "\"album\":{\"title\":\"B\",\"cover\":\"legacy-cover\"}}"));
+    query.exec();
+  }
+  QSqlDatabase::removeDatabase("seed");
+
+  QFile cover(coverPath);
+  cover.open(QIODevice::WriteOnly);
+  cover.write("jpeg");
+}
+
+static void checkMigration(DatabaseManager &db, const QString &legacyCover) {
+  QSqlQuery query(db.database());
+  query.exec("PRAGMA user_version");
+  check(query.next() && query.value(0).toInt() > 0,
+        "user_version was not set");
+
+  Track track = db.getTrack(42);
+  check(track.duration() == 200 && track.artistName() == "A",
+        "typed columns were not filled from json_data");
+
+  query.exec("SELECT json_data FROM favorites WHERE id = 42");
+  QCborValue raw = query.next()
+                       ? QCborValue::fromCbor(query.value(0).toByteArray())
+                       : QCborValue();
+  check(raw.toMap().value(QStringLiteral("audioQuality")).toString() ==
+            "LOSSLESS",
+        "json_data lost fields the model does not carry");
+
+  check(!QFile::exists(legacyCover), "legacy cover was left behind");
+  check(QFile::exists(DatabaseManager::coverStorePath("legacy-cover")),
+        "legacy cover did not reach the cover store");
+  query.exec("SELECT c.file_path, f.cover_path FROM covers c "
+             "JOIN favorites f ON f.cover_id = c.cover_id "
+             "WHERE c.cover_id = 'legacy-cover'");
+  check(query.next() && QFile::exists(query.value(0).toString()) &&
+            query.value(1) == query.value(0),
+        "cover rows do not name the stored file");
+}
+
+// A Tidal album saved again must find the copy made the first time
+static void checkSourceAlbums(DatabaseManager &db) {
+  check(db.getAlbumBySource(99) < 0, "found an album never saved");
+  int saved = db.createAlbum("Saved", QString(), 99);
+  check(saved >= 0 && db.getAlbumBySource(99) == saved,
+        "saved album was not found by its source");
+  check(db.createAlbum("Saved", QString(), 99) < 0,
+        "a source album was saved twice");
+}
+
+// Each hot query must seek an index: no table scan outside allowedScans,
+// and no sort into a temporary b-tree
+struct PlannedQuery {
+  QString name;
+  QString sql;
+  QStringList allowedScans;
+};
+
+static void checkQueryPlans(DatabaseManager &db) {
+  const QString track = "SELECT f.id, f.title, f.artist_id, f.artist, "
+                        "f.album, f.cover_id, f.duration, f.file_path, "
+                        "f.cover_path";
+  const QString favorites = track + ", f.added_at, f.id FROM favorites f "
+                                    "WHERE f.is_favorite = 1 ";
+  const QString albumTracks =
+      track + ", at.added_at, at.rowid FROM favorites f "
+              "JOIN album_tracks at ON f.id = at.track_id "
+              "WHERE at.album_id = :album_id ";
+  const QList<PlannedQuery> queries = {
+      {"favorites", favorites + "ORDER BY f.added_at, f.id", {}},
+      {"favorites page",
+       favorites + "AND (f.added_at, f.id) > (:added_at, :key) "
+                   "ORDER BY f.added_at, f.id LIMIT :limit",
+       {}},
+      {"favorite ids",
+       "SELECT f.id FROM favorites f WHERE f.is_favorite = 1 "
+       "ORDER BY f.added_at, f.id",
+       {}},
+      {"album tracks", albumTracks + "ORDER BY at.added_at, at.rowid", {}},
+      {"album by source",
+       "SELECT id FROM albums WHERE source_album_id = :source_album_id",
+       {}},
+      {"file paths",
+       "SELECT id, file_path FROM favorites WHERE file_path IS NOT NULL "
+       "AND file_path != '' AND id IN (?, ?, ?)",
+       {}},
+      // Walks every cover; each reference check is an index seek
+      {"unused covers",
+       "SELECT c.cover_id FROM covers c "
+       "WHERE NOT EXISTS (SELECT 1 FROM favorites f "
+       "WHERE f.cover_id = c.cover_id AND (f.is_favorite = 1 OR "
+       "EXISTS (SELECT 1 FROM album_tracks at "
+       "WHERE at.track_id = f.id))) "
+       "AND NOT EXISTS (SELECT 1 FROM albums a "
+       "WHERE a.cover_id = c.cover_id "
+       "OR a.cover_path = c.file_path)",
+       {"SCAN c"}},
+  };
+
+  static const QRegularExpression placeholder(":\\w+|\\?");
+  QSqlQuery query(db.database());
+  for (const PlannedQuery &planned : queries) {
+    // Plain exec needs every parameter; the plan does not depend on them
+    QString sql = planned.sql;
+    sql.replace(placeholder, "0");
+    if (!query.exec("EXPLAIN QUERY PLAN " + sql)) {
+      check(false, QString("%1: %2").arg(planned.name,
+                                         query.lastError().text()));
+      continue;
+    }
+    while (query.next()) {
+      QString detail = query.value(3).toString();
+      bool scan = detail.startsWith("SCAN") &&
+                  detail != "SCAN CONSTANT ROW" &&
+                  !planned.allowedScans.contains(detail);
+      check(!scan && !detail.contains("TEMP B-TREE"),
+            QString("%1 plan: %2").arg(planned.name, detail));
+    }
+  }
+}
+
+// Migrates a legacy database in a scratch location, then checks the result
+// and the plans of the hot queries. Exits with 1 if anything failed.
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  app.setApplicationName("db_test");
+
+  // A scratch database, never the user's
+  QStandardPaths::setTestModeEnabled(true);
+  QDir dir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+  dir.removeRecursively();
+  dir.mkpath("covers");
+  QString legacyCover = dir.filePath("covers/42.jpg");
+  seedLegacyDatabase(dir.filePath("hellyeah.db"), legacyCover);
+
+  DatabaseManager &db = DatabaseManager::instance();
+  checkMigration(db, legacyCover);
+  checkSourceAlbums(db);
+  checkQueryPlans(db);
+
+  if (failures > 0) {
+    qDebug() << failures << "checks failed";
+    return 1;
+  }
+  qDebug() << "All checks passed";
+  return 0;
+}
@@ -0,0 +1,50 @@
+#include "Track.hpp"
+#include <QSet>
+
+// Enough for the artists and albums of a few large pages. Strings already
+// handed out keep their buffers when the pool is dropped.
+static const qsizetype maxPooledStrings = 4096;
+
+QString internString(const QString &value) {
+  if (value.isEmpty())
+    return value;
+
+  // One pool per thread: parsing on the I/O thread takes no lock
+  static thread_local QSet<QString> pool;
+
+  auto it = pool.constFind(value);
+  if (it != pool.constEnd())
+    return *it;
+  if (pool.size() >= maxPooledStrings)
+    pool.clear();
+  pool.insert(value);
+  return value;
+}
+
+void Track::setArtist(int id, const QString &name) {
+  d->artistId = id;
+  d->artistName = internString(name);
+}
+
+void Track::setAlbum(const QString &title, const QString &cover) {
+  d->albumTitle = internString(title);
+  d->cover = internString(cover);
+}
+
+QJsonObject Track::toJson() const {
+  QJsonObject artist;
+  artist["id"] = d->artistId;
+  artist["name"] = d->artistName;
+
+  QJsonObject album;
+  album["title"] = d->albumTitle;
+  album["cover"] = d->cover;
+
+  QJsonObject obj;
+  obj["id"] = d->id;
+  obj["title"] = d->title;
+  obj["duration"] = d->duration;
+  obj["artist"] = artist;
+  obj["album"] = album;
+  return obj;
+}
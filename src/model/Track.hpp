@@ -0,0 +1,80 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QList>
+#include <QMetaType>
+#include <QSharedData>
+#include <QSharedDataPointer>
+#include <QString>
+
+// Returns a copy sharing its buffer with equal strings interned recently on
+// the same thread, so a page repeating the same artist or album stores its
+// name once. The pool is bounded and starts over when full.
+QString internString(const QString &value);
+
+struct Artist {
+  int id = 0;
+  QString name;
+  QString bio;
+};
+
+// A Tidal album or a user playlist
+struct Album {
+  int id = 0;
+  QString title;
+  QString artistName;
+  QString cover;     // Tidal cover UUID
+  QString coverPath; // Local cover file (user playlists)
+};
+
+class TrackData : public QSharedData {
+public:
+  int id = 0;
+  int duration = 0;
+  int artistId = 0;
+  QString title;
+  QString artistName; // interned
+  QString albumTitle; // interned
+  QString cover;      // interned Tidal cover UUID
+  QString filePath;
+  QString coverPath;
+};
+
+// Implicitly shared track value used from response parsing through storage
+// to the widgets. JSON only appears at the wire and json_data boundaries.
+class Track {
+public:
+  Track() : d(new TrackData) {}
+
+  bool isNull() const { return d->id == 0; }
+
+  int id() const { return d->id; }
+  QString title() const { return d->title; }
+  int duration() const { return d->duration; }
+  int artistId() const { return d->artistId; }
+  QString artistName() const { return d->artistName; }
+  QString albumTitle() const { return d->albumTitle; }
+  QString cover() const { return d->cover; }
+
+  // Local state kept by DatabaseManager
+  QString filePath() const { return d->filePath; }
+  QString coverPath() const { return d->coverPath; }
+
+  void setId(int id) { d->id = id; }
+  void setTitle(const QString &title) { d->title = title; }
+  void setDuration(int seconds) { d->duration = seconds; }
+  void setArtist(int id, const QString &name);
+  void setAlbum(const QString &title, const QString &cover);
+  void setFilePath(const QString &path) { d->filePath = path; }
+  void setCoverPath(const QString &path) { d->coverPath = path; }
+
+  // The modeled fields in wire format
+  QJsonObject toJson() const;
+
+private:
+  QSharedDataPointer<TrackData> d;
+};
+
+Q_DECLARE_METATYPE(Track)
+Q_DECLARE_METATYPE(Album)
+Q_DECLARE_METATYPE(Artist)
@@ -0,0 +1,101 @@
+#include "BandwidthGovernor.hpp"
+#include <QDebug>
+
+static const int tickIntervalMs = 50;
+// Capacity is sampled over windows this long
+static const qint64 sampleWindowMs = 250;
+// Share of the capacity background transfers keep while playback starves,
+// with a floor so their connections do not time out
+static const double starvingShare = 0.1;
+static const double minBackgroundRate = 32 * 1024;
+// Burst a reader can take at once: this long at the allowed rate
+static const double burstSeconds = 0.1;
+// The timer stops after this long without traffic
+static const qint64 idleStopMs = 2000;
+
+BandwidthGovernor::BandwidthGovernor(QObject *parent) : QObject(parent) {
+  tickTimer = new QTimer(this);
+  tickTimer->setInterval(tickIntervalMs);
+  connect(tickTimer, &QTimer::timeout, this, &BandwidthGovernor::onTick);
+  clock.start();
+}
+
+void BandwidthGovernor::recordTransfer(qint64 bytes) {
+  if (bytes <= 0)
+    return;
+  if (!tickTimer->isActive()) {
+    lastTick = windowStart = clock.elapsed();
+    windowBytes = 0;
+    tickTimer->start();
+  }
+  windowBytes += bytes;
+  idleSince = 0;
+}
+
+void BandwidthGovernor::setPlaybackBuffer(qint64 buffered, qint64 watermark) {
+  bool nowStarving = watermark > 0 && buffered < watermark;
+  if (nowStarving == starving)
+    return;
+  starving = nowStarving;
+  qDebug() << "BandwidthGovernor: playback" << (starving ? "buffering" : "ok")
+           << "- background limited to"
+           << (starving ? qint64(backgroundRate()) : -1) << "B/s";
+
+  if (starving) {
+    tokens = backgroundRate() * burstSeconds;
+    lastTick = clock.elapsed();
+    tickTimer->start();
+  }
+  emit playbackStarvingChanged(starving);
+  if (!starving) {
+    waiting = false;
+    emit released();
+  }
+}
+
+double BandwidthGovernor::backgroundRate() const {
+  return qMax(minBackgroundRate, linkCapacity * starvingShare);
+}
+
+qint64 BandwidthGovernor::acquire(qint64 wanted) {
+  if (!starving)
+    return wanted;
+  qint64 granted = qMin(wanted, qint64(tokens));
+  tokens -= granted;
+  if (granted < wanted)
+    waiting = true;
+  return granted;
+}
+
+void BandwidthGovernor::onTick() {
+  qint64 now = clock.elapsed();
+
+  if (starving) {
+    double rate = backgroundRate();
+    tokens = qMin(rate * burstSeconds,
+                  tokens + rate * (now - lastTick) / 1000.0);
+    if (waiting && tokens >= 1) {
+      waiting = false;
+      emit released();
+    }
+  }
+  lastTick = now;
+
+  if (now - windowStart >= sampleWindowMs) {
+    if (windowBytes > 0) {
+      double rate = windowBytes * 1000.0 / (now - windowStart);
+      // Rise quickly to a new peak; decay slowly, as a quiet window usually
+      // means little was asked for rather than a slower link
+      linkCapacity = rate > linkCapacity
+                         ? 0.5 * linkCapacity + 0.5 * rate
+                         : 0.98 * linkCapacity + 0.02 * rate;
+    } else if (idleSince == 0) {
+      idleSince = now;
+    }
+    windowBytes = 0;
+    windowStart = now;
+  }
+
+  if (!starving && idleSince > 0 && now - idleSince >= idleStopMs)
+    tickTimer->stop();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+// Keeps background transfers from slowing down playback. Every reply reports
+// the bytes it reads, from which the link capacity is estimated. While the
+// playback buffer is below its watermark, background readers draw from a
+// token bucket refilled at a small share of that capacity, and whatever
+// they leave unread stays in the socket, so TCP backs the sender off.
+//
+// Lives on NetworkAccess's I/O thread with the clients that use it; it is
+// not thread-safe.
+class BandwidthGovernor : public QObject {
+  Q_OBJECT
+
+public:
+  explicit BandwidthGovernor(QObject *parent = nullptr);
+
+  // Bytes read by any transfer, foreground or background
+  void recordTransfer(qint64 bytes);
+
+  // Playback has buffered bytes of the watermark it needs to play smoothly.
+  // A watermark of 0 means nothing is buffering.
+  void setPlaybackBuffer(qint64 buffered, qint64 watermark);
+  bool isPlaybackStarving() const { return starving; }
+
+  // Bytes a background reader may take now, at most wanted. Unthrottled
+  // unless playback is starving; released() follows when it is worth
+  // asking again.
+  qint64 acquire(qint64 wanted);
+
+  // Estimated link capacity in bytes per second, 0 until measured
+  double capacity() const { return linkCapacity; }
+
+signals:
+  void playbackStarvingChanged(bool starving);
+  // Background readers holding back may read again
+  void released();
+
+private:
+  QTimer *tickTimer;
+  QElapsedTimer clock;
+  qint64 lastTick = 0;
+  qint64 windowBytes = 0; // Read since the last capacity sample
+  qint64 windowStart = 0;
+  qint64 idleSince = 0;
+  double linkCapacity = 0;
+  double tokens = 0;
+  bool starving = false;
+  bool waiting = false; // A reader was refused since the last release
+
+  double backgroundRate() const;
+  void onTick();
+};
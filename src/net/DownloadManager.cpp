@@ -1,84 +1,764 @@
 #include "DownloadManager.hpp"
+#include "NetworkAccess.hpp"
 #include <QDebug>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QSaveFile>
 #include <QStandardPaths>
+#include <QThread>
+#include <QTimer>
+
+#include <cstdio>
+#include <cstring>
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#endif
+
+// Per-download memory stays at the reply buffer plus one shared chunk
+static const qint64 replyBufferSize = 256 * 1024;
+static const int chunkSize = 64 * 1024;
+// Progress written to download_queue at most this often
+static const qint64 persistInterval = 4 * 1024 * 1024;
+// A dropped transfer is retried after 2, 4, 8, 16 and 32 seconds
+static const int maxRetries = 5;
+static const int retryBaseDelayMs = 2000;
+// Progress is reported to the UI after this many new bytes
+static const qint64 progressInterval = 256 * 1024;
+// Only files with this much left are split, into ranges of at least
+// minSegmentSize; below that, connection setup outweighs the gain
+static const qint64 segmentThreshold = 16 * 1024 * 1024;
+static const qint64 minSegmentSize = 4 * 1024 * 1024;
+static const int defaultSegments = 4;
+// A download runs on one connection this long before it is split, which
+// measures what a single connection gets
+static const qint64 probeMs = 1000;
+
+static QString trackKey(int trackId) {
+  return "track:" + QString::number(trackId);
+}
+
+// Decodes cover data, trying JPEG first as the CDN serves it
+static QImage decodeImage(const QByteArray &data) {
+  QImage image;
+  if (!image.loadFromData(data, "JPG"))
+    image.loadFromData(data);
+  return image;
+}
 
 DownloadManager::DownloadManager(QObject *parent) : QObject(parent) {
-  manager = new QNetworkAccessManager(this);
-  connect(manager, &QNetworkAccessManager::finished, this,
-          &DownloadManager::onDownloadFinished);
+  // Shared manager: listen per reply rather than to every request in the app
+  manager = NetworkAccess::instance().manager();
+  chunkBuffer.resize(chunkSize);
+  segmentCount = defaultSegments;
+  scheduler = new TransferScheduler(this);
+
+  // Track downloads are background traffic: while playback is buffering
+  // only Interactive transfers and covers in view start, and reads are
+  // rationed
+  governor = NetworkAccess::instance().governor();
+  connect(governor, &BandwidthGovernor::playbackStarvingChanged, this,
+          [this](bool starving) { scheduler->setHeld(starving); });
+  connect(governor, &BandwidthGovernor::released, this,
+          &DownloadManager::resumeReads);
 }
 
-void DownloadManager::downloadTrack(const QString &url, int trackId) {
-  QUrl qurl(url);
-  QNetworkRequest request(qurl);
-  QNetworkReply *reply = manager->get(request);
-  activeDownloads.insert(reply, trackId);
+void DownloadManager::resumeReads() {
+  // A reply whose buffer is full gets no further readyRead until read
+  const QList<QNetworkReply *> replies = trackReplies.keys();
+  for (QNetworkReply *reply : replies) {
+    if (trackReplies.contains(reply))
+      writeAvailable(reply);
+  }
+}
+
+void DownloadManager::setMaxSegments(int segments) {
+  if (QThread::currentThread() != thread()) {
+    QMetaObject::invokeMethod(this,
+                              [this, segments]() { setMaxSegments(segments); });
+    return;
+  }
+  maxSegments = qMax(1, segments);
+  segmentCount = qBound(1, segmentCount, maxSegments);
+}
+
+void DownloadManager::downloadTrack(const QString &url, int trackId,
+                                    TransferScheduler::Priority priority) {
+  if (QThread::currentThread() != thread()) {
+    QMetaObject::invokeMethod(this, [this, url, trackId, priority]() {
+      downloadTrack(url, trackId, priority);
+    });
+    return;
+  }
+
+  if (activeDownloads.contains(trackId)) {
+    scheduler->enqueue(trackKey(trackId), priority, nullptr); // Upgrade only
+    return;
+  }
+
+  // Keep the progress of an unfinished download; only the URL is new. Its
+  // retries carry over too, so a URL the server keeps refusing gives up.
+  // Asking again for a download that gave up starts a fresh count.
+  QueuedDownload record = queue.value(trackId);
+  if (record.state == "failed")
+    record.retryCount = 0;
+  record.trackId = trackId;
+  record.url = url;
+  record.state = "queued";
+  queue.insert(trackId, record);
+  persist(record);
+  scheduleTrack(trackId, priority);
+}
+
+void DownloadManager::scheduleTrack(int trackId,
+                                    TransferScheduler::Priority priority) {
+  // The queue entry is read when the slot comes up, so a cancel or a newer
+  // URL in the meantime is honoured
+  scheduler->enqueue(trackKey(trackId), priority, [this, trackId]() {
+    if (queue.contains(trackId))
+      startTrackDownload(queue.value(trackId));
+    else
+      scheduler->finished(trackKey(trackId));
+  });
+}
+
+void DownloadManager::cancelTrack(int trackId) {
+  if (QThread::currentThread() != thread()) {
+    QMetaObject::invokeMethod(this,
+                              [this, trackId]() { cancelTrack(trackId); });
+    return;
+  }
+
+  scheduler->cancel(trackKey(trackId));
+  queue.remove(trackId);
+  singleConnection.remove(trackId);
+  DatabaseManager::instance().write(
+      [trackId]() { DatabaseManager::instance().removeDownload(trackId); });
+
+  auto it = activeDownloads.find(trackId);
+  if (it == activeDownloads.end()) {
+    QString partPath =
+        QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) +
+        "/downloads/" + QString::number(trackId) + ".flac.part";
+    QFile::remove(partPath);
+    return;
+  }
+
+  TrackDownload download = activeDownloads.take(trackId);
+  for (const Segment &segment : std::as_const(download.segments)) {
+    if (!segment.reply)
+      continue;
+    trackReplies.remove(segment.reply);
+    segment.reply->abort();
+    segment.reply->deleteLater();
+  }
+  download.file->close();
+  download.file->remove();
+  delete download.file;
+  scheduler->finished(trackKey(trackId));
+  qDebug() << "Download cancelled for track" << trackId;
+}
+
+void DownloadManager::prioritizeTrack(int trackId,
+                                      TransferScheduler::Priority priority) {
+  if (QThread::currentThread() != thread()) {
+    QMetaObject::invokeMethod(this, [this, trackId, priority]() {
+      prioritizeTrack(trackId, priority);
+    });
+    return;
+  }
+  scheduler->reprioritize(trackKey(trackId), priority);
+}
+
+void DownloadManager::restoreQueue(const QList<QueuedDownload> &downloads) {
+  if (QThread::currentThread() != thread()) {
+    QMetaObject::invokeMethod(this,
+                              [this, downloads]() { restoreQueue(downloads); });
+    return;
+  }
+
+  for (const QueuedDownload &download : downloads) {
+    queue.insert(download.trackId, download);
+    if (download.state == "expired")
+      emit streamUrlExpired(download.trackId);
+    else if (download.state != "failed")
+      scheduleTrack(download.trackId, TransferScheduler::Background);
+  }
+}
+
+void DownloadManager::startTrackDownload(QueuedDownload record) {
+  queue.remove(record.trackId);
+
+  QString dataPath =
+      QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+  QDir dir(dataPath);
+  if (!dir.exists("downloads")) {
+    dir.mkpath("downloads");
+  }
+
+  QString filePath = dir.filePath("downloads/" +
+                                  QString::number(record.trackId) +
+                                  ".flac"); // Assuming mp3/m4a
+  TrackDownload download;
+  download.file = new QFile(filePath + ".part", this);
+
+  // Resume only from bytes that are known to be on disk
+  download.resuming = record.bytesDone > 0 && download.file->exists() &&
+                      download.file->size() >= record.bytesDone;
+  if (!download.resuming) {
+    record.bytesDone = 0;
+    record.totalBytes = 0;
+    record.etag.clear();
+    record.lastModified.clear();
+  }
+  QIODevice::OpenMode mode = download.resuming
+                                 ? QIODevice::ReadWrite
+                                 : QIODevice::WriteOnly | QIODevice::Truncate;
+  if (!download.file->open(mode)) {
+    qDebug() << "Failed to save file for track" << record.trackId;
+    delete download.file;
+    scheduler->finished(trackKey(record.trackId));
+    return;
+  }
+
+  record.state = "active";
+  download.record = record;
+  download.persistedBytes = record.bytesDone;
+  download.lastProgress = record.bytesDone;
+  download.elapsed.start();
+  persist(record);
+
+  // The first request asks for everything left; it is cut down to the
+  // first segment if the file turns out to be worth splitting
+  Segment first;
+  first.offset = record.bytesDone;
+  first.reply = sendRange(record, first.offset, -1);
+  download.segments.append(first);
+  activeDownloads.insert(record.trackId, download);
+
+  connect(first.reply, &QNetworkReply::metaDataChanged, this,
+          [this, reply = first.reply]() { onTrackMetaData(reply); });
 }
 
-void DownloadManager::downloadCover(const QString &url, int trackId) {
-  QUrl qurl(url);
-  QNetworkRequest request(qurl);
+QNetworkReply *DownloadManager::sendRange(const QueuedDownload &record,
+                                          qint64 offset, qint64 end) {
+  QNetworkRequest request = NetworkAccess::instance().request(QUrl(record.url));
+  // Over HTTP/2 the ranges would be streams of one connection, which a
+  // per-connection CDN throttle limits as a whole. HTTP/1.1 opens one
+  // connection each, up to the manager's six per host.
+  request.setAttribute(QNetworkRequest::Http2AllowedAttribute, false);
+  if (offset > 0 || end >= 0) {
+    QByteArray range = "bytes=" + QByteArray::number(offset) + "-";
+    if (end >= 0)
+      range += QByteArray::number(end - 1);
+    request.setRawHeader("Range", range);
+    // The server sends the whole body instead if the file has changed
+    QString validator =
+        !record.etag.isEmpty() ? record.etag : record.lastModified;
+    if (!validator.isEmpty())
+      request.setRawHeader("If-Range", validator.toUtf8());
+  }
+
   QNetworkReply *reply = manager->get(request);
-  activeCoverDownloads.insert(reply, trackId);
+  // Data beyond this stays in the socket until we have written what we hold
+  reply->setReadBufferSize(replyBufferSize);
+  trackReplies.insert(reply, record.trackId);
+
+  connect(reply, &QNetworkReply::metaDataChanged, this,
+          [this, reply]() { onRangeMetaData(reply); });
+  connect(reply, &QNetworkReply::readyRead, this,
+          [this, reply]() { writeAvailable(reply); });
+  connect(reply, &QNetworkReply::finished, this,
+          [this, reply]() { onDownloadFinished(reply); });
+  return reply;
 }
 
-void DownloadManager::onDownloadFinished(QNetworkReply *reply) {
-  if (activeDownloads.contains(reply)) {
-    int trackId = activeDownloads.take(reply);
+void DownloadManager::persist(const QueuedDownload &record) {
+  // Queued on the DB thread, which keeps the saves in order
+  DatabaseManager::instance().write(
+      [record]() { DatabaseManager::instance().saveDownload(record); });
+}
 
-    if (reply->error() == QNetworkReply::NoError) {
-      QString dataPath =
-          QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-      QDir dir(dataPath);
-      if (!dir.exists("downloads")) {
-        dir.mkpath("downloads");
-      }
+DownloadManager::Segment *
+DownloadManager::findSegment(QNetworkReply *reply,
+                             TrackDownload **download) {
+  auto track = trackReplies.constFind(reply);
+  if (track == trackReplies.constEnd())
+    return nullptr;
+  auto it = activeDownloads.find(track.value());
+  if (it == activeDownloads.end())
+    return nullptr;
+  for (Segment &segment : it->segments) {
+    if (segment.reply == reply) {
+      if (download)
+        *download = &it.value();
+      return &segment;
+    }
+  }
+  return nullptr;
+}
 
-      QString filePath = dir.filePath("downloads/" + QString::number(trackId) +
-                                      ".flac"); // Assuming mp3/m4a
-      QFile file(filePath);
-      if (file.open(QIODevice::WriteOnly)) {
-        file.write(reply->readAll());
-        file.close();
-        emit downloadFinished(trackId, filePath);
-        qDebug() << "Download finished for track" << trackId << "at"
-                 << filePath;
-      } else {
-        qDebug() << "Failed to save file for track" << trackId;
-      }
-    } else {
-      qDebug() << "Download error for track" << trackId << ":"
-               << reply->errorString();
+void DownloadManager::onTrackMetaData(QNetworkReply *reply) {
+  TrackDownload *download = nullptr;
+  Segment *segment = findSegment(reply, &download);
+  if (!segment)
+    return;
+  int status =
+      reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  if (status != 200 && status != 206)
+    return;
+
+  QueuedDownload &record = download->record;
+  if (status == 200 && download->resuming) {
+    // Range ignored or validator stale: start the file over
+    download->resuming = false;
+    record.bytesDone = 0;
+    segment->offset = 0;
+    download->lastProgress = 0;
+    download->file->resize(0);
+  }
+
+  QVariant etag = reply->header(QNetworkRequest::ETagHeader);
+  if (etag.isValid())
+    record.etag = etag.toString();
+  QByteArray lastModified = reply->rawHeader("Last-Modified");
+  if (!lastModified.isEmpty())
+    record.lastModified = QString::fromLatin1(lastModified);
+  qint64 length =
+      reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+  if (length > 0)
+    record.totalBytes = record.bytesDone + length;
+  persist(record);
+
+  preallocate(*download);
+  // Split once the first connection has shown its rate
+  download->splittable = reply->rawHeader("Accept-Ranges") == "bytes";
+  download->probeStartMs = download->elapsed.elapsed();
+}
+
+void DownloadManager::onRangeMetaData(QNetworkReply *reply) {
+  TrackDownload *download = nullptr;
+  Segment *segment = findSegment(reply, &download);
+  if (!segment || segment == &download->segments.first())
+    return;
+  int status =
+      reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  if (status == 206)
+    return;
+
+  // writeAvailable() leaves any other body unread, so the capped read
+  // buffer would stall the reply. Fail the track and fetch it again on one
+  // connection. Queued, as abort() would finish the reply under our feet.
+  qDebug() << "Range refused with status" << status << "for track"
+           << download->record.trackId;
+  download->rangeRefused = true;
+  singleConnection.insert(download->record.trackId);
+  QMetaObject::invokeMethod(reply, &QNetworkReply::abort,
+                            Qt::QueuedConnection);
+}
+
+void DownloadManager::preallocate(const TrackDownload &download) {
+  qint64 length = download.record.totalBytes;
+  if (length <= 0 || download.file->size() >= length)
+    return;
+
+#ifdef Q_OS_LINUX
+  // Reserve the whole file up front: fewer extents, a full disk fails now
+  // rather than late, and segments can write at their offsets in any order
+  int error = posix_fallocate(download.file->handle(), 0, length);
+  if (error != 0)
+    qDebug() << "Could not preallocate" << length << "bytes for track"
+             << download.record.trackId << ":" << strerror(error);
+#endif
+}
+
+void DownloadManager::splitDownload(TrackDownload &download) {
+  download.splittable = false;
+  const QueuedDownload &record = download.record;
+  Segment &first = download.segments.first();
+
+  // The baseline is only ever measured on a lone connection
+  qint64 probedMs = download.elapsed.elapsed() - download.probeStartMs;
+  double singleRate = first.written * 1000.0 / qMax<qint64>(probedMs, 1);
+  connectionRate = connectionRate > 0
+                       ? 0.7 * connectionRate + 0.3 * singleRate
+                       : singleRate;
+
+  // The first range keeps what it has fetched; the rest is shared out
+  qint64 start = first.offset + first.written;
+  qint64 remaining = record.totalBytes - start;
+  // Ranges fetched separately must come from the same version of the file
+  bool validated = !record.etag.isEmpty() || !record.lastModified.isEmpty();
+  if (download.segments.size() > 1 || first.end >= 0 || segmentCount < 2 ||
+      remaining < segmentThreshold || !validated ||
+      singleConnection.contains(record.trackId))
+    return;
+
+  // Each further range holds a connection of the track's scheduler lane
+  int wanted = int(qMin<qint64>(segmentCount, remaining / minSegmentSize));
+  int count = 1 + scheduler->acquireExtra(trackKey(record.trackId),
+                                          wanted - 1);
+  if (count < 2)
+    return;
+  download.splitAtMs = download.elapsed.elapsed();
+  download.splitAtBytes = first.written;
+
+  qint64 size = remaining / count;
+  first.end = start + size;
+  for (int i = 1; i < count; ++i) {
+    Segment segment;
+    segment.offset = start + i * size;
+    segment.end = i == count - 1 ? record.totalBytes : segment.offset + size;
+    segment.reply = sendRange(record, segment.offset, segment.end);
+    download.segments.append(segment);
+  }
+  qDebug() << "Fetching track" << record.trackId << "in" << count
+           << "segments";
+}
+
+bool DownloadManager::writeAvailable(QNetworkReply *reply, bool throttled) {
+  TrackDownload *download = nullptr;
+  Segment *segment = findSegment(reply, &download);
+  if (!segment)
+    return false;
+  // Error bodies must not end up in the track file, and a later segment
+  // given the whole file instead of its range cannot be placed
+  int status =
+      reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  bool first = segment == &download->segments.first();
+  if (status != 206 && !(first && status == 200))
+    return false;
+
+  QFile *file = download->file;
+  while (reply->bytesAvailable() > 0 && !segment->complete) {
+    qint64 want = chunkBuffer.size();
+    if (segment->end >= 0)
+      want = qMin(want, segment->end - segment->offset - segment->written);
+    if (throttled)
+      want = governor->acquire(want);
+    if (want <= 0)
+      break; // Left in the socket until released()
+    qint64 n = reply->read(chunkBuffer.data(), want);
+    if (n <= 0)
+      break;
+    governor->recordTransfer(n);
+    // All segments share one handle; each writes at its own offset
+    qint64 position = segment->offset + segment->written;
+    if (file->pos() != position)
+      file->seek(position);
+    if (file->write(chunkBuffer.constData(), n) != n) {
+      qDebug() << "Write failed for track" << download->record.trackId
+               << ":" << file->errorString();
+      download->writeFailed = true;
+      reply->abort();
+      return false;
+    }
+    segment->written += n;
+    if (segment->end >= 0 &&
+        segment->offset + segment->written >= segment->end) {
+      segment->complete = true;
+      // The first request asked for the whole file; stop it at its range.
+      // Queued, as abort() would finish the reply under our feet.
+      if (reply->isRunning())
+        QMetaObject::invokeMethod(reply, &QNetworkReply::abort,
+                                  Qt::QueuedConnection);
     }
+  }
+
+  if (download->splittable &&
+      download->elapsed.elapsed() - download->probeStartMs >= probeMs)
+    splitDownload(*download); // segment is stale past this point
+
+  updateProgress(*download);
+  return true;
+}
+
+void DownloadManager::updateProgress(TrackDownload &download) {
+  QueuedDownload &record = download.record;
+  // Only the contiguous prefix is safe to resume from
+  qint64 received = 0;
+  record.bytesDone = download.segments.first().offset;
+  bool contiguous = true;
+  for (const Segment &segment : std::as_const(download.segments)) {
+    received += segment.written;
+    if (contiguous)
+      record.bytesDone = segment.offset + segment.written;
+    contiguous = contiguous && segment.complete;
+  }
+  received += download.segments.first().offset;
+
+  if (received - download.lastProgress >= progressInterval) {
+    download.lastProgress = received;
+    emit downloadProgress(record.trackId, received, record.totalBytes);
+  }
+  // Record progress now and then so a restart loses little
+  if (record.bytesDone - download.persistedBytes >= persistInterval) {
+    download.file->flush();
+    download.persistedBytes = record.bytesDone;
+    persist(record);
+  }
+}
+
+void DownloadManager::downloadCover(const QString &coverId, int pixels,
+                                    TransferScheduler::Priority priority) {
+  if (QThread::currentThread() != thread()) {
+    QMetaObject::invokeMethod(this, [this, coverId, pixels, priority]() {
+      downloadCover(coverId, pixels, priority);
+    });
+    return;
+  }
+
+  // Stored already, e.g. by another track of the same album
+  QString thumbnailPath = DatabaseManager::coverStorePath(coverId, pixels);
+  QImage thumbnail = loadImage(thumbnailPath);
+  if (!thumbnail.isNull()) {
+    emit coverDownloadFinished(coverId, pixels, thumbnailPath, thumbnail,
+                               false);
+    return;
+  }
+
+  // Covers stored whole before thumbnails existed are scaled down locally
+  QImage original = loadImage(DatabaseManager::coverStorePath(coverId));
+  if (original.width() >= pixels) {
+    saveThumbnail(coverId, pixels, original);
+    return;
+  }
+
+  // The scheduler keeps one request per UUID and variant; every size
+  // waiting on it is cut from the one response
+  int variant = coverVariant(pixels);
+  QString key = QString("cover:%1:%2").arg(coverId).arg(variant);
+  coverWaiters[key].insert(pixels);
+  scheduler->enqueue(key, priority, [this, key, coverId, variant]() {
+    QString path = coverId;
+    QUrl url(QString("https://resources.tidal.com/images/%1/%2x%2.jpg")
+                 .arg(path.replace("-", "/"))
+                 .arg(variant));
+    QNetworkRequest request = NetworkAccess::instance().request(url);
+    QNetworkReply *reply = manager->get(request);
+    activeCoverDownloads.insert(reply, {key, coverId});
+    connect(reply, &QNetworkReply::finished, this,
+            [this, reply]() { onDownloadFinished(reply); });
+  });
+}
+
+int DownloadManager::coverVariant(int pixels) {
+  // The square sizes the Tidal image CDN serves
+  static const int variants[] = {80, 160, 320, 640, 1280};
+  for (int variant : variants) {
+    if (variant >= pixels)
+      return variant;
+  }
+  return 1280;
+}
+
+QImage DownloadManager::loadImage(const QString &filePath) {
+  QFile file(filePath);
+  if (!file.open(QIODevice::ReadOnly))
+    return QImage();
+  return decodeImage(file.readAll());
+}
+
+void DownloadManager::saveThumbnail(const QString &coverId, int pixels,
+                                    const QImage &source) {
+  QImage thumbnail = source.width() == pixels
+                         ? source
+                         : source.scaled(pixels, pixels, Qt::KeepAspectRatio,
+                                         Qt::SmoothTransformation);
+  QString filePath = DatabaseManager::coverStorePath(coverId, pixels);
+  // Written whole or not at all, as other views may read it any time
+  QSaveFile file(filePath);
+  if (file.open(QIODevice::WriteOnly) && thumbnail.save(&file, "JPG", 90) &&
+      file.commit()) {
+    emit coverDownloadFinished(coverId, pixels, filePath, thumbnail, true);
+    qDebug() << "Cover stored for" << coverId << "at" << filePath;
+  } else {
+    qDebug() << "Failed to save cover file for" << coverId;
+  }
+}
+
+void DownloadManager::onDownloadFinished(QNetworkReply *reply) {
+  if (trackReplies.contains(reply)) {
+    finishSegment(reply);
     reply->deleteLater();
   } else if (activeCoverDownloads.contains(reply)) {
-    int trackId = activeCoverDownloads.take(reply);
+    CoverRequest request = activeCoverDownloads.take(reply);
+    scheduler->finished(request.key);
+    const QSet<int> sizes = coverWaiters.take(request.key);
 
     if (reply->error() == QNetworkReply::NoError) {
-      QString dataPath =
-          QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-      QDir dir(dataPath);
-      if (!dir.exists("covers")) {
-        dir.mkpath("covers");
-      }
-
-      QString filePath =
-          dir.filePath("covers/" + QString::number(trackId) + ".jpg");
-      QFile file(filePath);
-      if (file.open(QIODevice::WriteOnly)) {
-        file.write(reply->readAll());
-        file.close();
-        emit coverDownloadFinished(trackId, filePath);
-        qDebug() << "Cover download finished for track" << trackId << "at"
-                 << filePath;
+      QByteArray data = reply->readAll();
+      governor->recordTransfer(data.size());
+      QImage image = decodeImage(data);
+      if (image.isNull()) {
+        qDebug() << "Failed to decode cover" << request.coverId;
       } else {
-        qDebug() << "Failed to save cover file for track" << trackId;
+        for (int pixels : sizes)
+          saveThumbnail(request.coverId, pixels, image);
       }
     } else {
-      qDebug() << "Cover download error for track" << trackId << ":"
+      qDebug() << "Cover download error for" << request.coverId << ":"
                << reply->errorString();
     }
     reply->deleteLater();
   }
 }
+
+void DownloadManager::finishSegment(QNetworkReply *reply) {
+  TrackDownload *download = nullptr;
+  Segment *segment = findSegment(reply, &download);
+  if (!segment) {
+    trackReplies.remove(reply);
+    return; // The track already failed through another segment
+  }
+
+  // A segment stopped at its range end reports OperationCanceledError
+  bool done = segment->complete;
+  // Drain what is left; it has already arrived, so no rationing
+  if (!done && reply->error() == QNetworkReply::NoError &&
+      writeAvailable(reply, false)) {
+    done = segment->end < 0 ||
+           segment->offset + segment->written >= segment->end;
+    if (segment->end < 0)
+      segment->end = segment->offset + segment->written;
+  }
+  trackReplies.remove(reply);
+  segment->reply = nullptr;
+
+  if (!done) {
+    int trackId = download->record.trackId;
+    TrackDownload failed = activeDownloads.take(trackId);
+    // Stop the sibling ranges; what they wrote past the prefix is refetched
+    for (const Segment &other : std::as_const(failed.segments)) {
+      if (!other.reply)
+        continue;
+      trackReplies.remove(other.reply);
+      other.reply->abort();
+      other.reply->deleteLater();
+    }
+    failTrackDownload(failed, reply);
+    return;
+  }
+
+  segment->complete = true;
+  for (const Segment &other : std::as_const(download->segments)) {
+    if (!other.complete) {
+      // Its connection goes back to the lane
+      scheduler->releaseExtra(trackKey(download->record.trackId));
+      return;
+    }
+  }
+  completeTrackDownload(activeDownloads.take(download->record.trackId));
+}
+
+void DownloadManager::adaptSegmentCount(const TrackDownload &download) {
+  int connections = download.segments.size();
+  if (connections < 2 || connectionRate <= 0)
+    return;
+  // Only the part fetched in parallel, against the lone-connection probe
+  qint64 elapsedMs = download.elapsed.elapsed() - download.splitAtMs;
+  qint64 received = -download.splitAtBytes;
+  for (const Segment &segment : download.segments)
+    received += segment.written;
+  if (elapsedMs < 1000 || received < minSegmentSize)
+    return; // Too short to say anything about throughput
+
+  // If every connection kept roughly the rate one connection gets, the CDN
+  // is throttling per connection and another one will add to the total; if
+  // they ended up sharing the link, use fewer
+  double perConnection = received * 1000.0 / elapsedMs / connections;
+  double scaling = perConnection / connectionRate;
+  if (scaling > 0.75)
+    segmentCount = qMin(segmentCount + 1, maxSegments);
+  else if (scaling < 0.5)
+    segmentCount = qMax(segmentCount - 1, 2);
+}
+
+void DownloadManager::completeTrackDownload(TrackDownload download) {
+  QueuedDownload record = download.record;
+  scheduler->finished(trackKey(record.trackId));
+  singleConnection.remove(record.trackId);
+  QFile *file = download.file;
+  QString partPath = file->fileName();
+  QString filePath = partPath.chopped(5); // Drop ".part"
+  adaptSegmentCount(download);
+
+  // Trim any preallocated tail the body did not fill
+  file->resize(download.segments.last().end);
+  file->close();
+  delete file;
+  // rename() replaces an existing file atomically
+  if (std::rename(QFile::encodeName(partPath).constData(),
+                  QFile::encodeName(filePath).constData()) == 0) {
+    DatabaseManager::instance().write([trackId = record.trackId]() {
+      DatabaseManager::instance().removeDownload(trackId);
+    });
+    emit downloadFinished(record.trackId, filePath);
+    qDebug() << "Download finished for track" << record.trackId << "at"
+             << filePath;
+  } else {
+    qDebug() << "Failed to save file for track" << record.trackId;
+    record.state = "failed";
+    persist(record);
+  }
+}
+
+void DownloadManager::failTrackDownload(TrackDownload download,
+                                        QNetworkReply *reply) {
+  QueuedDownload record = download.record;
+  scheduler->finished(trackKey(record.trackId));
+  // Keep the partial file; the next attempt continues from bytesDone
+  download.file->flush();
+  download.file->close();
+  delete download.file;
+  int status =
+      reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  qDebug() << "Download error for track" << record.trackId << ":"
+           << reply->errorString();
+
+  // Aborted from outside, e.g. on shutdown: resume on the next run. An abort
+  // after a failed write or a refused range takes the retry path below
+  // instead.
+  if (reply->error() == QNetworkReply::OperationCanceledError &&
+      !download.writeFailed && !download.rangeRefused) {
+    record.state = "paused";
+    queue.insert(record.trackId, record);
+    persist(record);
+    return;
+  }
+
+  bool expired =
+      status == 401 || status == 403 || status == 404 || status == 410;
+  if (expired && record.retryCount < maxRetries) {
+    // Signed stream URLs expire; a fresh one resumes from the same offset.
+    // Counted, so a track the server refuses for good is not refetched
+    // forever.
+    record.retryCount++;
+    record.state = "expired";
+    queue.insert(record.trackId, record);
+    persist(record);
+    emit streamUrlExpired(record.trackId);
+    return;
+  }
+
+  if (status == 416) // Offset past the end: the file changed under us
+    record.bytesDone = 0;
+
+  if (++record.retryCount > maxRetries) {
+    record.state = "failed";
+    queue.insert(record.trackId, record);
+    persist(record);
+    emit downloadFailed(record.trackId);
+    return;
+  }
+
+  // Network dropped: retry from where we stopped once it may be back
+  record.state = "paused";
+  queue.insert(record.trackId, record);
+  persist(record);
+  int delay = retryBaseDelayMs << (record.retryCount - 1);
+  int trackId = record.trackId;
+  QTimer::singleShot(delay, this, [this, trackId]() {
+    if (queue.contains(trackId) && queue.value(trackId).state == "paused")
+      scheduleTrack(trackId, TransferScheduler::Background);
+  });
+}
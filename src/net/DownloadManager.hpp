@@ -1,28 +1,128 @@
 #pragma once
 
+#include "../db/DatabaseManager.hpp"
+#include "BandwidthGovernor.hpp"
+#include "TransferScheduler.hpp"
+#include <QElapsedTimer>
 #include <QFile>
+#include <QHash>
+#include <QImage>
 #include <QMap>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QObject>
+#include <QSet>
 
+// Lives on NetworkAccess's I/O thread, where replies are written to disk and
+// images decoded. Calls from other threads are re-posted to it. Transfers
+// start through a TransferScheduler, so each call names its priority lane.
 class DownloadManager : public QObject {
   Q_OBJECT
 
 public:
   explicit DownloadManager(QObject *parent = nullptr);
-  void downloadTrack(const QString &url, int trackId);
-  void downloadCover(const QString &url, int trackId);
+  // Large files are fetched as several byte ranges over parallel
+  // connections, each counted against the scheduler's limits; 1 turns
+  // this off
+  void setMaxSegments(int segments);
+  void downloadTrack(
+      const QString &url, int trackId,
+      TransferScheduler::Priority priority = TransferScheduler::Prefetch);
+  // Drops a queued or running track download along with its partial file
+  void cancelTrack(int trackId);
+  // Moves a track download to another lane, e.g. when the user plays it
+  void prioritizeTrack(int trackId, TransferScheduler::Priority priority);
+  // Resumes downloads left unfinished by an earlier run
+  void restoreQueue(const QList<QueuedDownload> &downloads);
+  // Puts a pixels-square thumbnail of the cover with this Tidal UUID in the
+  // cover store. Fetches the smallest CDN variant that covers it, unless the
+  // thumbnail or a large enough original is on disk already.
+  void downloadCover(
+      const QString &coverId, int pixels,
+      TransferScheduler::Priority priority = TransferScheduler::VisibleCover);
 
 signals:
   void downloadFinished(int trackId, const QString &filePath);
-  void coverDownloadFinished(int trackId, const QString &coverPath);
+  // Bytes on disk across all segments; bytesTotal is 0 until known
+  void downloadProgress(int trackId, qint64 bytesReceived, qint64 bytesTotal);
+  // image is the thumbnail, ready for QPixmap::fromImage. stored is true
+  // when coverPath was just written, false when it was in the store already.
+  void coverDownloadFinished(const QString &coverId, int pixels,
+                             const QString &coverPath, const QImage &image,
+                             bool stored);
+  // The stream URL was refused; pass a fresh one to downloadTrack to resume
+  void streamUrlExpired(int trackId);
+  // Retries are exhausted; the partial file stays for a later attempt
+  void downloadFailed(int trackId);
 
 private slots:
   void onDownloadFinished(QNetworkReply *reply);
 
 private:
+  // One request filling [offset, end) of the track file
+  struct Segment {
+    QNetworkReply *reply = nullptr; // Null once finished
+    qint64 offset = 0;
+    qint64 end = -1; // Unknown until the first segment is cut or finishes
+    qint64 written = 0;
+    bool complete = false;
+  };
+
+  // A track streams into <id>.flac.part, renamed into place once complete.
+  // The record mirrors its download_queue row so a partial file can resume.
+  struct TrackDownload {
+    QueuedDownload record;
+    QFile *file = nullptr;
+    QList<Segment> segments; // Ordered by offset
+    QElapsedTimer elapsed;
+    qint64 persistedBytes = 0;
+    qint64 lastProgress = 0;
+    bool resuming = false;
+    bool splittable = false;  // Ranges accepted and not split yet
+    qint64 probeStartMs = 0;  // Headers of the first range arrived
+    qint64 splitAtMs = 0;     // When further ranges were requested
+    qint64 splitAtBytes = 0;  // Fetched by then
+    bool writeFailed = false; // Aborted because the file could not be written
+    bool rangeRefused = false; // A later range was answered with the file
+  };
+
   QNetworkAccessManager *manager;
-  QMap<QNetworkReply *, int> activeDownloads;
-  QMap<QNetworkReply *, int> activeCoverDownloads;
+  TransferScheduler *scheduler;
+  BandwidthGovernor *governor;
+  QHash<int, TrackDownload> activeDownloads;
+  QHash<QNetworkReply *, int> trackReplies; // Segment reply to track id
+  int maxSegments = 6; // The manager opens six HTTP/1.1 connections per host
+  int segmentCount = 0; // Adapted to the measured throughput
+  double connectionRate = 0; // Bytes/s a lone connection gets, smoothed
+  QSet<int> singleConnection; // Tracks whose server refused a later range
+  // Unfinished downloads waiting for a retry or a fresh stream URL
+  QHash<int, QueuedDownload> queue;
+  QByteArray chunkBuffer; // Shared by all downloads; they run on one thread
+  struct CoverRequest {
+    QString key; // Scheduler key, one per UUID and CDN variant
+    QString coverId;
+  };
+  QMap<QNetworkReply *, CoverRequest> activeCoverDownloads;
+  QHash<QString, QSet<int>> coverWaiters; // Thumbnail sizes per request key
+
+  void scheduleTrack(int trackId, TransferScheduler::Priority priority);
+  void startTrackDownload(QueuedDownload record);
+  QNetworkReply *sendRange(const QueuedDownload &record, qint64 offset,
+                           qint64 end);
+  void persist(const QueuedDownload &record);
+  Segment *findSegment(QNetworkReply *reply, TrackDownload **download);
+  void onTrackMetaData(QNetworkReply *reply);
+  void onRangeMetaData(QNetworkReply *reply);
+  void preallocate(const TrackDownload &download);
+  void splitDownload(TrackDownload &download);
+  bool writeAvailable(QNetworkReply *reply, bool throttled = true);
+  void resumeReads();
+  void updateProgress(TrackDownload &download);
+  void finishSegment(QNetworkReply *reply);
+  void adaptSegmentCount(const TrackDownload &download);
+  void completeTrackDownload(TrackDownload download);
+  void failTrackDownload(TrackDownload download, QNetworkReply *reply);
+  static int coverVariant(int pixels);
+  static QImage loadImage(const QString &filePath);
+  void saveThumbnail(const QString &coverId, int pixels, const QImage &source);
 };
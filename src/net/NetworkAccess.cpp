@@ -0,0 +1,147 @@
+#include "NetworkAccess.hpp"
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QMutexLocker>
+#include <QNetworkReply>
+#include <QSaveFile>
+#include <QSslConfiguration>
+#include <QStandardPaths>
+#include <QUrl>
+
+NetworkAccess &NetworkAccess::instance() {
+  static NetworkAccess instance;
+  return instance;
+}
+
+NetworkAccess::NetworkAccess(QObject *parent) : QObject(parent) {
+  m_manager = new QNetworkAccessManager(this);
+  m_governor = new BandwidthGovernor(this);
+
+  QString dataPath =
+      QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+  QDir().mkpath(dataPath);
+  m_ticketPath = QDir(dataPath).filePath("tls_sessions.dat");
+  loadTickets();
+
+  connect(m_manager, &QNetworkAccessManager::encrypted, this,
+          &NetworkAccess::onEncrypted);
+
+  m_ioThread = new QThread;
+  m_ioThread->setObjectName("io");
+  moveToThread(m_ioThread);
+  m_ioThread->start();
+
+  // Wind the thread down while the application still exists; objects living
+  // on it are deleted as it finishes
+  QThread *thread = m_ioThread;
+  connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit,
+          QCoreApplication::instance(), [thread]() {
+            thread->quit();
+            thread->wait();
+          });
+}
+
+NetworkAccess::~NetworkAccess() {
+  m_ioThread->quit();
+  m_ioThread->wait();
+  delete m_ioThread;
+}
+
+QSslConfiguration NetworkAccess::sslConfiguration(const QString &host) const {
+  QSslConfiguration config = QSslConfiguration::defaultConfiguration();
+  // Session persistence must be on for Qt to hand out and accept tickets
+  config.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+  QMutexLocker locker(&m_ticketMutex);
+  auto it = m_tickets.constFind(host);
+  if (it != m_tickets.constEnd() &&
+      it->expiresAt > QDateTime::currentMSecsSinceEpoch()) {
+    config.setSessionTicket(it->ticket);
+  }
+  return config;
+}
+
+QNetworkRequest NetworkAccess::request(const QUrl &url) const {
+  QNetworkRequest request(url);
+  request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+  if (url.scheme() == "https")
+    request.setSslConfiguration(sslConfiguration(url.host()));
+  return request;
+}
+
+void NetworkAccess::preconnect(const QStringList &baseUrls) {
+  // The manager may only be used from the I/O thread
+  QMetaObject::invokeMethod(this, [this, baseUrls]() {
+    for (const QString &baseUrl : baseUrls) {
+      QUrl url(baseUrl);
+      if (url.scheme() != "https")
+        continue;
+      qDebug() << "NetworkAccess: Pre-connecting to" << url.host();
+      // Without h2 offered, the manager warms an HTTP/1.1 connection that
+      // requests allowed HTTP/2 will not use
+      QSslConfiguration config = sslConfiguration(url.host());
+      config.setAllowedNextProtocols(
+          {QSslConfiguration::ALPNProtocolHTTP2,
+           QSslConfiguration::NextProtocolHttp1_1});
+      m_manager->connectToHostEncrypted(url.host(), url.port(443), config);
+    }
+  });
+}
+
+void NetworkAccess::onEncrypted(QNetworkReply *reply) {
+  QSslConfiguration config = reply->sslConfiguration();
+  QByteArray ticket = config.sessionTicket();
+  if (ticket.isEmpty())
+    return;
+
+  QString host = reply->url().host();
+  QMutexLocker locker(&m_ticketMutex);
+  SessionTicket &stored = m_tickets[host];
+  if (stored.ticket == ticket)
+    return; // Resumed with the ticket we already have
+
+  stored.ticket = ticket;
+  int lifetime = config.sessionTicketLifeTimeHint();
+  stored.expiresAt = QDateTime::currentMSecsSinceEpoch() +
+                     qint64(lifetime > 0 ? lifetime : 3600) * 1000;
+  locker.unlock();
+  saveTickets();
+}
+
+void NetworkAccess::loadTickets() {
+  QFile file(m_ticketPath);
+  if (!file.open(QIODevice::ReadOnly))
+    return;
+
+  QDataStream in(&file);
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+  while (!in.atEnd()) {
+    QString host;
+    SessionTicket stored;
+    in >> host >> stored.ticket >> stored.expiresAt;
+    if (in.status() != QDataStream::Ok)
+      break;
+    if (stored.expiresAt > now)
+      m_tickets.insert(host, stored);
+  }
+  qDebug() << "NetworkAccess: Loaded" << m_tickets.size() << "TLS sessions";
+}
+
+void NetworkAccess::saveTickets() const {
+  QSaveFile file(m_ticketPath);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qDebug() << "NetworkAccess: Cannot write" << m_ticketPath;
+    return;
+  }
+
+  QMutexLocker locker(&m_ticketMutex);
+  QHash<QString, SessionTicket> tickets = m_tickets;
+  locker.unlock();
+
+  QDataStream out(&file);
+  for (auto it = tickets.constBegin(); it != tickets.constEnd(); ++it)
+    out << it.key() << it->ticket << it->expiresAt;
+  file.commit();
+}
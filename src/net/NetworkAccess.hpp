@@ -0,0 +1,59 @@
+#pragma once
+
+#include "BandwidthGovernor.hpp"
+#include <QHash>
+#include <QMutex>
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QStringList>
+#include <QThread>
+
+// The one QNetworkAccessManager every client uses, so all requests share a
+// connection pool, DNS cache and TLS session cache. TLS session tickets are
+// kept on disk, letting the first request to a host after a restart resume
+// the previous session instead of doing a full handshake.
+//
+// The manager lives on a dedicated I/O thread. Objects that use it (the API
+// client, downloads, the player's stream fetcher) are moved there too, read
+// and write replies off the GUI thread, and report back by queued signals.
+class NetworkAccess : public QObject {
+  Q_OBJECT
+
+public:
+  static NetworkAccess &instance();
+
+  QNetworkAccessManager *manager() const { return m_manager; }
+  QThread *ioThread() const { return m_ioThread; }
+  // Lives on the I/O thread; use it from there only
+  BandwidthGovernor *governor() const { return m_governor; }
+
+  // Request with HTTP/2 allowed and the stored session ticket for its host
+  QNetworkRequest request(const QUrl &url) const;
+
+  // Opens TLS connections ahead of the first request to each base URL
+  void preconnect(const QStringList &baseUrls);
+
+private:
+  explicit NetworkAccess(QObject *parent = nullptr);
+  ~NetworkAccess();
+  NetworkAccess(const NetworkAccess &) = delete;
+  NetworkAccess &operator=(const NetworkAccess &) = delete;
+
+  struct SessionTicket {
+    QByteArray ticket;
+    qint64 expiresAt = 0; // ms since epoch
+  };
+
+  QThread *m_ioThread;
+  QNetworkAccessManager *m_manager;
+  BandwidthGovernor *m_governor;
+  mutable QMutex m_ticketMutex; // request() is called from any thread
+  QHash<QString, SessionTicket> m_tickets; // By host
+  QString m_ticketPath;
+
+  QSslConfiguration sslConfiguration(const QString &host) const;
+  void onEncrypted(QNetworkReply *reply);
+  void loadTickets();
+  void saveTickets() const;
+};
@@ -0,0 +1,190 @@
+#include "OfflineSync.hpp"
+#include "../db/DatabaseManager.hpp"
+#include <QDebug>
+#include <QFile>
+
+// Tracks whose stream URL is being resolved or whose file is downloading
+static const int maxInFlight = 4;
+// Finished file paths are written together after this quiet period
+static const int flushDelayMs = 2000;
+// Progress needed before an ETA means anything
+static const double minEtaProgress = 0.02;
+
+OfflineSync::OfflineSync(HifiClient *client, DownloadManager *downloads,
+                         QObject *parent)
+    : QObject(parent), client(client), downloads(downloads) {
+  flushTimer = new QTimer(this);
+  flushTimer->setSingleShot(true);
+  flushTimer->setInterval(flushDelayMs);
+  connect(flushTimer, &QTimer::timeout, this, &OfflineSync::flush);
+
+  connect(client, &HifiClient::trackStreamUrl, this,
+          &OfflineSync::onStreamUrl);
+  connect(client, &HifiClient::trackStreamFailed, this,
+          &OfflineSync::onStreamFailed);
+  connect(downloads, &DownloadManager::streamUrlExpired, this,
+          &OfflineSync::onStreamUrlExpired);
+  connect(downloads, &DownloadManager::downloadProgress, this,
+          &OfflineSync::onDownloadProgress);
+  connect(downloads, &DownloadManager::downloadFinished, this,
+          &OfflineSync::onDownloadFinished);
+  connect(downloads, &DownloadManager::downloadFailed, this,
+          [this](int trackId) {
+            if (downloading.contains(trackId))
+              complete(trackId, false);
+          });
+}
+
+void OfflineSync::syncTracks(const QList<Track> &tracks, int coverPixels) {
+  QList<int> trackIds;
+  for (const Track &track : tracks)
+    trackIds.append(track.id());
+  // One query for the album, not one per track
+  DatabaseManager::instance()
+      .read([trackIds]() {
+        return DatabaseManager::instance().getFilePaths(trackIds);
+      })
+      .then(this, [this, tracks,
+                   coverPixels](const QHash<int, QString> &localPaths) {
+        queueTracks(tracks, coverPixels, localPaths);
+      });
+}
+
+void OfflineSync::queueTracks(const QList<Track> &tracks, int coverPixels,
+                              const QHash<int, QString> &localPaths) {
+  if (total == 0)
+    elapsed.start();
+
+  QSet<QString> covers;
+  for (const Track &track : tracks) {
+    int trackId = track.id();
+    if (isSyncing(trackId))
+      continue;
+    if (!track.cover().isEmpty())
+      covers.insert(track.cover());
+    QString localPath = localPaths.value(trackId);
+    if (!localPath.isEmpty() && QFile::exists(localPath))
+      continue;
+    waiting.append(trackId);
+    total++;
+  }
+  // Usually one cover for a whole album
+  for (const QString &coverId : std::as_const(covers))
+    downloads->downloadCover(coverId, coverPixels,
+                             TransferScheduler::Background);
+
+  qDebug() << "OfflineSync:" << waiting.size() << "tracks waiting";
+  startNext();
+  reportProgress();
+}
+
+void OfflineSync::cancelTrack(int trackId) {
+  // Already downloaded; the caller removes the file, so the path must not
+  // be recorded
+  if (finishedPaths.remove(trackId))
+    return;
+  bool wasQueued = waiting.removeOne(trackId) || resolving.remove(trackId) ||
+                   downloading.remove(trackId);
+  if (!wasQueued)
+    return;
+  total--;
+  startNext();
+  reportProgress();
+}
+
+bool OfflineSync::isSyncing(int trackId) const {
+  return resolving.contains(trackId) || downloading.contains(trackId) ||
+         finishedPaths.contains(trackId) || waiting.contains(trackId);
+}
+
+void OfflineSync::startNext() {
+  while (!waiting.isEmpty() &&
+         resolving.size() + downloading.size() < maxInFlight) {
+    int trackId = waiting.takeFirst();
+    resolving.insert(trackId);
+    client->getTrackStream(trackId);
+  }
+
+  if (total > 0 && waiting.isEmpty() && resolving.isEmpty() &&
+      downloading.isEmpty()) {
+    flush();
+    qDebug() << "OfflineSync: done," << done - failed << "downloaded,"
+             << failed << "failed";
+    emit finished(done - failed, failed);
+    total = done = failed = 0;
+  }
+}
+
+void OfflineSync::onStreamUrl(int trackId, const QString &url) {
+  if (!resolving.remove(trackId))
+    return; // Playback or a favorite asked for it
+  downloading.insert(trackId, 0);
+  downloads->downloadTrack(url, trackId, TransferScheduler::Background);
+}
+
+void OfflineSync::onStreamFailed(int trackId) {
+  if (resolving.contains(trackId))
+    complete(trackId, false);
+}
+
+void OfflineSync::onStreamUrlExpired(int trackId) {
+  if (!downloading.contains(trackId))
+    return;
+  // Keeps its slot; the download resumes from its partial file
+  downloading.remove(trackId);
+  resolving.insert(trackId);
+  client->getTrackStream(trackId);
+}
+
+void OfflineSync::onDownloadProgress(int trackId, qint64 received,
+                                     qint64 bytesTotal) {
+  auto it = downloading.find(trackId);
+  if (it == downloading.end() || bytesTotal <= 0)
+    return;
+  *it = double(received) / bytesTotal;
+  reportProgress();
+}
+
+void OfflineSync::onDownloadFinished(int trackId, const QString &filePath) {
+  if (!downloading.contains(trackId))
+    return;
+  finishedPaths.insert(trackId, filePath);
+  flushTimer->start();
+  complete(trackId, true);
+}
+
+void OfflineSync::complete(int trackId, bool ok) {
+  resolving.remove(trackId);
+  downloading.remove(trackId);
+  done++;
+  if (!ok)
+    failed++;
+  reportProgress();
+  startNext();
+}
+
+void OfflineSync::flush() {
+  flushTimer->stop();
+  if (finishedPaths.isEmpty())
+    return;
+  DatabaseManager::instance().write([paths = finishedPaths]() {
+    if (!DatabaseManager::instance().updateFilePaths(paths))
+      qDebug() << "OfflineSync: could not record" << paths.size()
+               << "file paths";
+  });
+  finishedPaths.clear();
+}
+
+void OfflineSync::reportProgress() {
+  if (total == 0)
+    return;
+  double progressDone = done;
+  for (double share : std::as_const(downloading))
+    progressDone += share;
+  double fraction = progressDone / total;
+
+  int etaSecs = -1;
+  if (fraction >= minEtaProgress)
+    etaSecs = qRound(elapsed.elapsed() / 1000.0 * (1 - fraction) / fraction);
+  emit progress(done, total, etaSecs);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "../api/HifiClient.hpp"
+#include "DownloadManager.hpp"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+
+// Makes a batch of tracks available offline, e.g. a whole album. Stream URLs
+// are resolved only a few tracks ahead of the downloads, so signed URLs do not
+// expire while queued. Audio goes through the Background lane and covers
+// alongside it. Finished file paths are written in batched transactions.
+//
+// Lives on the GUI thread. The client and download manager it drives live on
+// the I/O thread and answer through queued signals; the database is read and
+// written through its async API.
+class OfflineSync : public QObject {
+  Q_OBJECT
+
+public:
+  OfflineSync(HifiClient *client, DownloadManager *downloads,
+              QObject *parent = nullptr);
+
+  // Queues the tracks not on disk yet, and their covers at coverPixels. A
+  // sync started while another runs joins it and shares its progress.
+  void syncTracks(const QList<Track> &tracks, int coverPixels);
+  // Drops a track that is no longer wanted; its download is the caller's
+  void cancelTrack(int trackId);
+  // The sync owns the track's stream URL and file_path until it is written
+  bool isSyncing(int trackId) const;
+
+signals:
+  // etaSecs is -1 until there is enough progress to estimate from
+  void progress(int done, int total, int etaSecs);
+  void finished(int downloaded, int failed);
+
+private:
+  HifiClient *client;
+  DownloadManager *downloads;
+  QList<int> waiting;                // Not started yet, in order
+  QSet<int> resolving;               // Stream URL requested
+  QHash<int, double> downloading;    // Share of each file on disk
+  QHash<int, QString> finishedPaths; // Waiting for the next flush
+  QTimer *flushTimer;
+  QElapsedTimer elapsed;
+  int total = 0;
+  int done = 0;
+  int failed = 0;
+
+  // Queues what the read of their file paths found missing
+  void queueTracks(const QList<Track> &tracks, int coverPixels,
+                   const QHash<int, QString> &localPaths);
+  void startNext();
+  void onStreamUrl(int trackId, const QString &url);
+  void onStreamFailed(int trackId);
+  void onStreamUrlExpired(int trackId);
+  void onDownloadProgress(int trackId, qint64 received, qint64 bytesTotal);
+  void onDownloadFinished(int trackId, const QString &filePath);
+  void complete(int trackId, bool ok);
+  void flush();
+  void reportProgress();
+};
@@ -0,0 +1,187 @@
+#include "TransferScheduler.hpp"
+
+// Transfers outside the Interactive lane share this many connections
+static const int sharedLimit = 8;
+// A queued job climbs one lane for every this long it waits
+static const qint64 agingIntervalMs = 15000;
+
+TransferScheduler::TransferScheduler(QObject *parent) : QObject(parent) {
+  clock.start();
+}
+
+int TransferScheduler::laneLimit(Priority priority) const {
+  switch (priority) {
+  case Interactive:
+    return 4;
+  case VisibleCover:
+    return 6;
+  case Prefetch:
+    return 3;
+  case Background:
+    return 2;
+  }
+  return 1;
+}
+
+int TransferScheduler::sharedRunning() const {
+  int connections = 0;
+  for (int lane = VisibleCover; lane <= Background; ++lane)
+    connections += runningPerLane[lane];
+  return connections;
+}
+
+int TransferScheduler::connectionsOf(const QString &key) const {
+  return 1 + extraSlots.value(key);
+}
+
+double TransferScheduler::rank(const Job &job, qint64 now) const {
+  // Lower runs first; ties go to the job queued earlier
+  return job.priority - double(now - job.enqueuedAt) / agingIntervalMs;
+}
+
+void TransferScheduler::enqueue(const QString &key, Priority priority,
+                                std::function<void()> start) {
+  if (running.contains(key)) {
+    if (priority < running.value(key))
+      reprioritize(key, priority);
+    return;
+  }
+
+  for (Job &job : pending) {
+    if (job.key == key) {
+      job.start = std::move(start);
+      job.priority = qMin(job.priority, priority);
+      dispatch();
+      return;
+    }
+  }
+
+  Job job;
+  job.key = key;
+  job.priority = priority;
+  job.enqueuedAt = clock.elapsed();
+  job.start = std::move(start);
+  pending.append(job);
+  dispatch();
+}
+
+void TransferScheduler::finished(const QString &key) {
+  auto it = running.find(key);
+  if (it == running.end())
+    return;
+  runningPerLane[it.value()] -= connectionsOf(key);
+  extraSlots.remove(key);
+  running.erase(it);
+  dispatch();
+}
+
+int TransferScheduler::acquireExtra(const QString &key, int wanted) {
+  auto it = running.constFind(key);
+  if (it == running.constEnd() || wanted <= 0)
+    return 0;
+  Priority priority = it.value();
+  // Only room no queued job of the lane could take
+  for (const Job &job : std::as_const(pending)) {
+    if (job.priority == priority)
+      return 0;
+  }
+  int granted = qMin(wanted, laneLimit(priority) - runningPerLane[priority]);
+  if (priority != Interactive)
+    granted = qMin(granted, sharedLimit - sharedRunning());
+  if (granted <= 0)
+    return 0;
+  extraSlots[key] += granted;
+  runningPerLane[priority] += granted;
+  return granted;
+}
+
+void TransferScheduler::releaseExtra(const QString &key) {
+  auto it = extraSlots.find(key);
+  if (it == extraSlots.end())
+    return;
+  runningPerLane[running.value(key)]--;
+  if (--it.value() == 0)
+    extraSlots.erase(it);
+  dispatch();
+}
+
+bool TransferScheduler::cancel(const QString &key) {
+  for (int i = 0; i < pending.size(); ++i) {
+    if (pending[i].key == key) {
+      pending.removeAt(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+void TransferScheduler::reprioritize(const QString &key, Priority priority) {
+  auto it = running.find(key);
+  if (it != running.end()) {
+    // The slots move lanes, which may free room for the old lane
+    runningPerLane[it.value()] -= connectionsOf(key);
+    runningPerLane[priority] += connectionsOf(key);
+    it.value() = priority;
+  } else {
+    for (Job &job : pending) {
+      if (job.key == key) {
+        job.priority = priority;
+        job.enqueuedAt = clock.elapsed();
+        break;
+      }
+    }
+  }
+  dispatch();
+}
+
+void TransferScheduler::setHeld(bool hold) {
+  held = hold;
+  if (!held)
+    dispatch();
+}
+
+bool TransferScheduler::isQueued(const QString &key) const {
+  for (const Job &job : pending) {
+    if (job.key == key)
+      return true;
+  }
+  return false;
+}
+
+bool TransferScheduler::isRunning(const QString &key) const {
+  return running.contains(key);
+}
+
+void TransferScheduler::dispatch() {
+  // A start() that fails at once calls finished() from inside this loop;
+  // the outer call picks up the freed slot
+  if (dispatching)
+    return;
+  dispatching = true;
+
+  while (!pending.isEmpty()) {
+    qint64 now = clock.elapsed();
+    int best = -1;
+    for (int i = 0; i < pending.size(); ++i) {
+      const Job &job = pending[i];
+      if (runningPerLane[job.priority] >= laneLimit(job.priority))
+        continue;
+      if (job.priority != Interactive && sharedRunning() >= sharedLimit)
+        continue;
+      // Covers in view are small and keep loading while playback buffers
+      if (held && job.priority > VisibleCover)
+        continue;
+      if (best < 0 || rank(job, now) < rank(pending[best], now))
+        best = i;
+    }
+    if (best < 0)
+      break;
+
+    Job job = pending.takeAt(best);
+    running.insert(job.key, job.priority);
+    runningPerLane[job.priority]++;
+    job.start();
+  }
+
+  dispatching = false;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <functional>
+
+// Orders DownloadManager's transfers into priority lanes, each with its own
+// concurrency limit, under a shared limit for everything but interactive
+// work. Jobs waiting long enough are aged ahead of newer, more urgent ones so
+// background sync cannot starve. Not thread-safe: used on the I/O thread.
+class TransferScheduler : public QObject {
+  Q_OBJECT
+
+public:
+  enum Priority { Interactive, VisibleCover, Prefetch, Background };
+  Q_ENUM(Priority)
+
+  explicit TransferScheduler(QObject *parent = nullptr);
+
+  // Queues start under key and runs it once its lane has a free slot. A key
+  // that is already queued takes the new start and the more urgent priority;
+  // a running key is only reprioritized.
+  void enqueue(const QString &key, Priority priority,
+               std::function<void()> start);
+  // Frees the slots of a running job and starts whatever fits next
+  void finished(const QString &key);
+  // Lends a running job up to wanted more connections of its lane, within
+  // the shared limit and only if no queued job of that lane waits. Returns
+  // how many it got; they count until released or finished().
+  int acquireExtra(const QString &key, int wanted);
+  // Returns one connection lent by acquireExtra()
+  void releaseExtra(const QString &key);
+  // Drops a queued job. Running jobs must be stopped by their owner, which
+  // then calls finished(). Returns true if a queued job was removed.
+  bool cancel(const QString &key);
+  // Moves a queued or running job to another lane
+  void reprioritize(const QString &key, Priority priority);
+  // While held, only Interactive and VisibleCover jobs start; running ones
+  // are left alone
+  void setHeld(bool held);
+
+  bool isQueued(const QString &key) const;
+  bool isRunning(const QString &key) const;
+
+private:
+  struct Job {
+    QString key;
+    Priority priority = Background;
+    qint64 enqueuedAt = 0;
+    std::function<void()> start;
+  };
+
+  QList<Job> pending;
+  QHash<QString, Priority> running;
+  QHash<QString, int> extraSlots; // Connections beyond the first, per job
+  int runningPerLane[Background + 1] = {}; // Connections, not jobs
+  QElapsedTimer clock;
+  bool dispatching = false;
+  bool held = false;
+
+  int laneLimit(Priority priority) const;
+  int sharedRunning() const;
+  int connectionsOf(const QString &key) const;
+  double rank(const Job &job, qint64 now) const;
+  void dispatch();
+};
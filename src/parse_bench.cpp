@@ -0,0 +1,136 @@
+#include "api/ResponseParser.hpp"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Counts heap allocations so both parse paths can be compared. Replacing
+// the global operator new is portable; Qt's string and array storage goes
+// through malloc instead, so the count covers node and d-pointer
+// allocations, which is where the DOM path spends most of its.
+static std::atomic<quint64> allocationCount{0};
+
+void *operator new(std::size_t size) {
+  allocationCount++;
+  if (void *ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+// The DOM path HifiClient used before ResponseParser
+static int domTracks(const QByteArray &data) {
+  QJsonObject root = QJsonDocument::fromJson(data).object();
+  QJsonArray tracks;
+  if (root.contains("tracks")) {
+    tracks = root["tracks"].toObject()["items"].toArray();
+  } else if (root.contains("items")) {
+    tracks = root["items"].toArray();
+  }
+  int count = 0;
+  for (const auto &val : tracks) {
+    QJsonObject track = val.toObject();
+    count += track["title"].toString().size() > 0;
+    count += track["artist"].toObject()["name"].toString().size() > 0;
+  }
+  return count;
+}
+
+static int domStreamUrl(const QByteArray &data) {
+  QJsonDocument doc = QJsonDocument::fromJson(data);
+  if (doc.isArray() && doc.array().isEmpty())
+    return 0;
+  QJsonObject root =
+      doc.isArray() ? doc.array().last().toObject() : doc.object();
+  QByteArray decoded =
+      QByteArray::fromBase64(root["manifest"].toString().toUtf8());
+  QJsonArray urls = QJsonDocument::fromJson(decoded).object()["urls"].toArray();
+  return urls.isEmpty() ? 0 : urls[0].toString().size();
+}
+
+static int scanTracks(const QByteArray &data) {
+  int count = 0;
+  for (const Track &track : ResponseParser::parseTracks(data)) {
+    count += track.title().size() > 0;
+    count += track.artistName().size() > 0;
+  }
+  return count;
+}
+
+static int scanStreamUrl(const QByteArray &data) {
+  return ResponseParser::parseStreamUrl(data).size();
+}
+
+static void run(const char *label, int (*parse)(const QByteArray &),
+                const QByteArray &data, int iterations) {
+  int sink = 0;
+  quint64 allocationsBefore = allocationCount;
+  QElapsedTimer timer;
+  timer.start();
+  for (int i = 0; i < iterations; ++i)
+    sink += parse(data);
+  qint64 ns = timer.nsecsElapsed();
+  quint64 allocations = allocationCount - allocationsBefore;
+
+  qDebug().noquote() << QString("  %1 %2 us/parse, %3 allocations/parse "
+                                "(checksum %4)")
+                            .arg(QString::fromLatin1(label), -6)
+                            .arg(ns / 1000.0 / iterations, 0, 'f', 1)
+                            .arg(allocations / iterations)
+                            .arg(sink / iterations);
+}
+
+// Usage: parse_bench [-n iterations] [recorded response]...
+// Files containing a "manifest" key are treated as /track/ responses, all
+// others as search or top-track responses. Without files, the recorded
+// responses in bench/ are used.
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  QStringList args = app.arguments().mid(1);
+
+  int iterations = 200;
+  if (args.size() >= 2 && args[0] == "-n") {
+    iterations = qMax(1, args[1].toInt());
+    args = args.mid(2);
+  }
+  if (args.isEmpty()) {
+    QDir fixtures(BENCH_DATA_DIR);
+    for (const QString &name : fixtures.entryList({"*.json"}, QDir::Files))
+      args.append(fixtures.filePath(name));
+  }
+  if (args.isEmpty()) {
+    qDebug() << "Usage: parse_bench [-n iterations] [response.json]...";
+    return 1;
+  }
+
+  for (const QString &path : args) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+      qDebug() << "Cannot open" << path;
+      continue;
+    }
+    QByteArray data = file.readAll();
+    bool isStream = data.contains("\"manifest\"");
+
+    qDebug().noquote() << path << "(" << data.size() << "bytes )";
+    if (isStream) {
+      run("dom", domStreamUrl, data, iterations);
+      run("scan", scanStreamUrl, data, iterations);
+    } else {
+      run("dom", domTracks, data, iterations);
+      run("scan", scanTracks, data, iterations);
+    }
+  }
+  return 0;
+}
@@ -2,16 +2,25 @@
 #include "miniaudio.h"
 
 #include "AudioPlayer.hpp"
+#include "../net/NetworkAccess.hpp"
 #include <QDebug>
 #include <QDir>
+#include <QStandardPaths>
 #include <QTimer>
 
 AudioPlayer::AudioPlayer(QObject *parent)
-    : QObject(parent), currentReply(nullptr), tempFile(nullptr),
+    : QObject(parent), fetcher(new StreamFetcher), tempFile(nullptr),
       engine(nullptr), sound(nullptr), isEngineInitialized(false),
       isSoundInitialized(false), m_hasEmittedFinished(false), m_volume(1.0f) {
 
-  manager = new QNetworkAccessManager(this);
+  // Stream data is received and written to disk off the GUI thread
+  QThread *ioThread = NetworkAccess::instance().ioThread();
+  fetcher->moveToThread(ioThread);
+  connect(ioThread, &QThread::finished, fetcher, &QObject::deleteLater);
+  connect(fetcher, &StreamFetcher::finished, this,
+          &AudioPlayer::onFetchFinished);
+  connect(fetcher, &StreamFetcher::failed, this, &AudioPlayer::onFetchFailed);
+
   positionTimer = new QTimer(this);
   positionTimer->setInterval(100); // Update every 100ms
   connect(positionTimer, &QTimer::timeout, this, &AudioPlayer::onPositionTimer);
@@ -58,11 +67,8 @@ void AudioPlayer::cleanupMiniaudio() {
 void AudioPlayer::playUrl(const QString &url) {
   stop(); // Stop current playback
 
-  if (currentReply) {
-    currentReply->abort();
-    currentReply->deleteLater();
-    currentReply = nullptr;
-  }
+  fetcher->cancel();
+  currentFetchId++; // Ignore anything the old fetch already reported
 
   if (tempFile) {
     delete tempFile;
@@ -82,22 +88,23 @@ void AudioPlayer::playUrl(const QString &url) {
     return;
   }
 
-  // Create a temp file
-  tempFile = new QTemporaryFile(this);
+  // Create a temp file under playback/, which storage compaction keeps
+  // within its quota
+  QDir playbackDir(
+      QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+  playbackDir.mkpath("playback");
+  tempFile =
+      new QTemporaryFile(playbackDir.filePath("playback/stream_XXXXXX"), this);
   if (!tempFile->open()) {
     emit errorOccurred("Could not create temporary file.");
     return;
   }
 
-  qDebug() << "Downloading to temp file:" << tempFile->fileName();
-
-  QNetworkRequest request(qUrl);
-  currentReply = manager->get(request);
+  // The fetcher reopens it by name; the temporary file keeps it until deleted
+  tempFile->close();
 
-  connect(currentReply, &QNetworkReply::finished, this,
-          &AudioPlayer::onDownloadFinished);
-  connect(currentReply, &QNetworkReply::downloadProgress, this,
-          &AudioPlayer::onDownloadProgress);
+  qDebug() << "Downloading to temp file:" << tempFile->fileName();
+  fetcher->fetch(currentFetchId, qUrl, tempFile->fileName());
 }
 
 void AudioPlayer::startPlayback(const QString &filePath) {
@@ -121,38 +128,20 @@ void AudioPlayer::startPlayback(const QString &filePath) {
   emit durationChanged(duration());
 }
 
-void AudioPlayer::onDownloadProgress(qint64 bytesReceived, qint64 bytesTotal) {
-  if (tempFile && currentReply) {
-    QByteArray data = currentReply->readAll();
-    tempFile->write(data);
-  }
+void AudioPlayer::onFetchFinished(int fetchId, const QString &filePath) {
+  if (fetchId != currentFetchId)
+    return; // Finished just before being superseded
+
+  qDebug() << "Download finished. Playing...";
+  startPlayback(filePath);
 }
 
-void AudioPlayer::onDownloadFinished() {
-  if (!currentReply)
+void AudioPlayer::onFetchFailed(int fetchId, const QString &message) {
+  if (fetchId != currentFetchId)
     return;
 
-  if (currentReply->error() == QNetworkReply::NoError) {
-    // Write any remaining data
-    QByteArray data = currentReply->readAll();
-    tempFile->write(data);
-    tempFile->flush();
-    tempFile->close(); // Close to flush to disk, but QTemporaryFile keeps it
-                       // until deleted
-
-    qDebug() << "Download finished. Playing...";
-
-    qDebug() << "Download finished. Playing...";
-
-    startPlayback(tempFile->fileName());
-
-  } else {
-    qDebug() << "AudioPlayer download failed:" << currentReply->errorString();
-    emit errorOccurred("Download error: " + currentReply->errorString());
-  }
-
-  currentReply->deleteLater();
-  currentReply = nullptr;
+  qDebug() << "AudioPlayer download failed:" << message;
+  emit errorOccurred("Download error: " + message);
 }
 
 void AudioPlayer::play() {
@@ -1,8 +1,7 @@
 #pragma once
 
+#include "StreamFetcher.hpp"
 #include <QFile>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
 #include <QObject>
 #include <QTemporaryFile>
 #include <QTimer>
@@ -35,13 +34,13 @@ signals:
   void errorOccurred(const QString &message);
 
 private slots:
-  void onDownloadFinished();
-  void onDownloadProgress(qint64 bytesReceived, qint64 bytesTotal);
+  void onFetchFinished(int fetchId, const QString &filePath);
+  void onFetchFailed(int fetchId, const QString &message);
   void onPositionTimer();
 
 private:
-  QNetworkAccessManager *manager;
-  QNetworkReply *currentReply;
+  StreamFetcher *fetcher; // Lives on the I/O thread
+  int currentFetchId = 0;
   QTemporaryFile *tempFile;
   QTimer *positionTimer;
 
@@ -0,0 +1,90 @@
+#include "StreamFetcher.hpp"
+#include "../net/NetworkAccess.hpp"
+#include <QDebug>
+#include <QThread>
+
+#include <limits>
+
+StreamFetcher::StreamFetcher(QObject *parent) : QObject(parent) {}
+
+void StreamFetcher::fetch(int fetchId, const QUrl &url,
+                          const QString &filePath) {
+  if (QThread::currentThread() != thread()) {
+    QMetaObject::invokeMethod(this, [this, fetchId, url, filePath]() {
+      fetch(fetchId, url, filePath);
+    });
+    return;
+  }
+
+  cancel();
+  currentFetchId = fetchId;
+
+  file.setFileName(filePath);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    emit failed(fetchId, "Could not open " + filePath);
+    return;
+  }
+
+  // Until the size is known, count the whole stream as below the watermark
+  NetworkAccess::instance().governor()->setPlaybackBuffer(
+      0, std::numeric_limits<qint64>::max());
+
+  QNetworkRequest request = NetworkAccess::instance().request(url);
+  reply = NetworkAccess::instance().manager()->get(request);
+  connect(reply, &QNetworkReply::readyRead, this, &StreamFetcher::onReadyRead);
+  connect(reply, &QNetworkReply::finished, this, &StreamFetcher::onFinished);
+}
+
+void StreamFetcher::cancel() {
+  if (QThread::currentThread() != thread()) {
+    QMetaObject::invokeMethod(this, [this]() { cancel(); });
+    return;
+  }
+
+  if (!reply)
+    return;
+  // Detach first: abort() emits finished synchronously
+  QNetworkReply *aborted = reply;
+  reply = nullptr;
+  aborted->abort();
+  aborted->deleteLater();
+  file.close();
+  NetworkAccess::instance().governor()->setPlaybackBuffer(0, 0);
+}
+
+void StreamFetcher::onReadyRead() {
+  if (!reply || sender() != reply)
+    return;
+  QByteArray data = reply->readAll();
+  file.write(data);
+
+  // AudioPlayer opens the file only once it is complete, so no shorter
+  // watermark would let it start sooner. Covers in view keep loading
+  // meanwhile; TransferScheduler holds back only prefetch and sync.
+  BandwidthGovernor *governor = NetworkAccess::instance().governor();
+  governor->recordTransfer(data.size());
+  qint64 length =
+      reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+  if (length > 0)
+    governor->setPlaybackBuffer(file.size(), length);
+}
+
+void StreamFetcher::onFinished() {
+  if (!reply || sender() != reply)
+    return;
+
+  QNetworkReply *done = reply;
+  reply = nullptr;
+  NetworkAccess::instance().governor()->setPlaybackBuffer(0, 0);
+
+  if (done->error() == QNetworkReply::NoError) {
+    file.write(done->readAll());
+    file.close();
+    emit finished(currentFetchId, file.fileName());
+  } else {
+    file.close();
+    qDebug() << "StreamFetcher: download failed:" << done->errorString();
+    emit failed(currentFetchId, done->errorString());
+  }
+  done->deleteLater();
+}
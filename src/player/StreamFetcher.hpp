@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QFile>
+#include <QNetworkReply>
+#include <QObject>
+#include <QUrl>
+
+// Downloads a stream into a file on the I/O thread for AudioPlayer. Reply
+// data is written as it arrives; the player only hears about the finished
+// file. Each fetch carries an id so results of superseded fetches can be
+// told apart. Until the file is complete the BandwidthGovernor holds
+// background transfers back.
+class StreamFetcher : public QObject {
+  Q_OBJECT
+
+public:
+  explicit StreamFetcher(QObject *parent = nullptr);
+
+  // Both may be called from any thread
+  void fetch(int fetchId, const QUrl &url, const QString &filePath);
+  void cancel();
+
+signals:
+  void finished(int fetchId, const QString &filePath);
+  void failed(int fetchId, const QString &message);
+
+private:
+  QNetworkReply *reply = nullptr;
+  QFile file;
+  int currentFetchId = 0;
+
+  void onReadyRead();
+  void onFinished();
+};
@@ -1,9 +1,11 @@
 #include "AlbumCard.hpp"
+#include <QMenu>
 #include <QMouseEvent>
 #include <QVBoxLayout>
+#include <QtMath>
 
-AlbumCard::AlbumCard(const QJsonObject &albumData, QWidget *parent)
-    : QWidget(parent), m_albumData(albumData) {
+AlbumCard::AlbumCard(const Album &album, QWidget *parent)
+    : QWidget(parent), m_album(album) {
 
   setFixedHeight(80);
   setCursor(Qt::PointingHandCursor);
@@ -14,7 +16,7 @@ AlbumCard::AlbumCard(const QJsonObject &albumData, QWidget *parent)
 
   // Cover art
   coverLabel = new QLabel(this);
-  coverLabel->setFixedSize(60, 60);
+  coverLabel->setFixedSize(coverSize, coverSize);
   // coverLabel->setScaledContents(true); // Removed to prevent stretching
   coverLabel->setStyleSheet("background-color: #282828; border-radius: 4px;");
   coverLabel->setAlignment(Qt::AlignCenter);
@@ -28,12 +30,12 @@ AlbumCard::AlbumCard(const QJsonObject &albumData, QWidget *parent)
   textLayout->setAlignment(Qt::AlignVCenter);
 
   // Title
-  QString title = albumData["title"].toString();
+  QString title = album.title;
   titleLabel = new QLabel(title, this);
   titleLabel->setStyleSheet("font-weight: bold; font-size: 14px; color: #fff;");
 
   // Artist
-  QString artist = albumData["artist"].toObject()["name"].toString();
+  QString artist = album.artistName;
   artistLabel = new QLabel(artist, this);
   artistLabel->setStyleSheet("font-size: 12px; color: #b3b3b3;");
 
@@ -68,8 +70,13 @@ AlbumCard::AlbumCard(const QJsonObject &albumData, QWidget *parent)
 
 void AlbumCard::setCoverImage(const QPixmap &pixmap) {
   if (!pixmap.isNull()) {
-    coverLabel->setPixmap(pixmap.scaled(60, 60, Qt::KeepAspectRatioByExpanding,
-                                        Qt::SmoothTransformation));
+    qreal dpr = devicePixelRatioF();
+    int pixels = qCeil(coverSize * dpr);
+    QPixmap sized =
+        pixmap.scaled(pixels, pixels, Qt::KeepAspectRatioByExpanding,
+                      Qt::SmoothTransformation);
+    sized.setDevicePixelRatio(dpr);
+    coverLabel->setPixmap(sized);
     coverLabel->setText("");
   }
 }
@@ -77,6 +84,19 @@ void AlbumCard::setCoverImage(const QPixmap &pixmap) {
 void AlbumCard::mousePressEvent(QMouseEvent *event) {
   if (event->button() == Qt::LeftButton) {
     emit clicked(getAlbumId());
+  } else if (event->button() == Qt::RightButton) {
+    QMenu contextMenu(this);
+    contextMenu.setStyleSheet(
+        "QMenu { background-color: #282828; color: #fff; border: 1px solid "
+        "#333; }"
+        "QMenu::item { padding: 5px 20px; }"
+        "QMenu::item:selected { background-color: #333; }");
+
+    QAction *offlineAction = contextMenu.addAction("Make Available Offline");
+    connect(offlineAction, &QAction::triggered, this,
+            [this]() { emit offlineClicked(getAlbumId()); });
+
+    contextMenu.exec(event->globalPos());
   }
   QWidget::mousePressEvent(event);
 }
@@ -1,7 +1,7 @@
 #pragma once
 
+#include "../model/Track.hpp"
 #include <QHBoxLayout>
-#include <QJsonObject>
 #include <QLabel>
 #include <QPixmap>
 #include <QPushButton>
@@ -11,15 +11,17 @@ class AlbumCard : public QWidget {
   Q_OBJECT
 
 public:
-  explicit AlbumCard(const QJsonObject &albumData, QWidget *parent = nullptr);
+  explicit AlbumCard(const Album &album, QWidget *parent = nullptr);
 
+  static constexpr int coverSize = 60; // Logical pixels, square
   void setCoverImage(const QPixmap &pixmap);
-  int getAlbumId() const { return m_albumData["id"].toInt(); }
-  QJsonObject getAlbumData() const { return m_albumData; }
+  int getAlbumId() const { return m_album.id; }
+  Album getAlbum() const { return m_album; }
 
 signals:
   void clicked(int albumId);
   void deleteClicked(int albumId);
+  void offlineClicked(int albumId);
 
 protected:
   void mousePressEvent(QMouseEvent *event) override;
@@ -27,7 +29,7 @@ protected:
   void leaveEvent(QEvent *event) override;
 
 private:
-  QJsonObject m_albumData;
+  Album m_album;
   QLabel *coverLabel;
   QLabel *titleLabel;
   QLabel *artistLabel;
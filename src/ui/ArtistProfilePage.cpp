@@ -2,6 +2,7 @@
 #include <QGraphicsDropShadowEffect>
 #include <QGridLayout>
 #include <QHBoxLayout>
+#include <QMenu>
 #include <QMouseEvent>
 #include <QScrollBar>
 
@@ -141,18 +142,18 @@ void ArtistProfilePage::setupUI() {
                 "}");
 }
 
-void ArtistProfilePage::setArtistData(const QJsonObject &artistData) {
-  m_artistData = artistData;
+void ArtistProfilePage::setArtistData(const Artist &artist) {
+  m_artist = artist;
 
-  if (artistData.isEmpty()) {
+  if (artist.id == 0 && artist.name.isEmpty()) {
     artistNameLabel->setText("Artist Not Found");
     bioLabel->setText("Could not load artist data. Please try again later.");
     bioLabel->show();
     return;
   }
 
-  QString name = artistData["name"].toString();
-  QString bio = artistData["bio"].toString();
+  QString name = artist.name;
+  QString bio = artist.bio;
 
   artistNameLabel->setText(name);
 
@@ -176,18 +177,16 @@ void ArtistProfilePage::setArtistCover(const QPixmap &cover) {
   }
 }
 
-void ArtistProfilePage::setTopTracks(const QJsonArray &tracks) {
+void ArtistProfilePage::setTopTracks(const QList<Track> &tracks) {
   clearTopTracks();
 
   int count = 0;
-  for (const auto &val : tracks) {
+  for (const Track &track : tracks) {
     if (count >= 10)
       break; // Limit to top 10
 
-    QJsonObject track = val.toObject();
-    int trackId = track["id"].toInt();
-    QString title = track["title"].toString();
-    QString duration = track["duration"].toString(); // Might need formatting
+    int trackId = track.id();
+    QString title = track.title();
 
     // Create track row
     QWidget *trackRow = new QWidget(this);
@@ -240,7 +239,7 @@ void ArtistProfilePage::setTopTracks(const QJsonArray &tracks) {
   }
 }
 
-void ArtistProfilePage::setAlbums(const QJsonArray &albums) {
+void ArtistProfilePage::setAlbums(const QList<Album> &albums) {
   clearAlbums();
 
   // Use horizontal layout for albums
@@ -248,10 +247,9 @@ void ArtistProfilePage::setAlbums(const QJsonArray &albums) {
   albumsHLayout->setSpacing(15);
   albumsHLayout->setContentsMargins(0, 0, 0, 0);
 
-  for (const auto &val : albums) {
-    QJsonObject album = val.toObject();
-    int albumId = album["id"].toInt();
-    QString title = album["title"].toString();
+  for (const Album &album : albums) {
+    int albumId = album.id;
+    QString title = album.title;
 
     // Create album card
     QWidget *albumCard = new QWidget(this);
@@ -348,6 +346,22 @@ bool ArtistProfilePage::eventFilter(QObject *obj, QEvent *event) {
       // Check if it's an album card
       QVariant albumIdVar = widget->property("albumId");
       if (albumIdVar.isValid()) {
+        auto *mouseEvent = static_cast<QMouseEvent *>(event);
+        if (mouseEvent->button() == Qt::RightButton) {
+          QMenu contextMenu(this);
+          contextMenu.setStyleSheet(
+              "QMenu { background-color: #282828; color: #fff; border: 1px "
+              "solid #333; }"
+              "QMenu::item { padding: 5px 20px; }"
+              "QMenu::item:selected { background-color: #333; }");
+          QAction *offlineAction =
+              contextMenu.addAction("Make Available Offline");
+          int albumId = albumIdVar.toInt();
+          connect(offlineAction, &QAction::triggered, this,
+                  [this, albumId]() { emit albumOfflineClicked(albumId); });
+          contextMenu.exec(mouseEvent->globalPosition().toPoint());
+          return true;
+        }
         emit albumClicked(albumIdVar.toInt());
         return true;
       }
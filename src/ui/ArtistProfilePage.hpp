@@ -1,8 +1,7 @@
 #pragma once
 
+#include "../model/Track.hpp"
 #include <QEvent>
-#include <QJsonArray>
-#include <QJsonObject>
 #include <QLabel>
 #include <QObject>
 #include <QPixmap>
@@ -17,15 +16,16 @@ class ArtistProfilePage : public QWidget {
 public:
   explicit ArtistProfilePage(QWidget *parent = nullptr);
 
-  void setArtistData(const QJsonObject &artistData);
-  void setTopTracks(const QJsonArray &tracks);
-  void setAlbums(const QJsonArray &albums);
+  void setArtistData(const Artist &artist);
+  void setTopTracks(const QList<Track> &tracks);
+  void setAlbums(const QList<Album> &albums);
   void setArtistCover(const QPixmap &cover);
 
 signals:
   void backClicked();
   void trackClicked(int trackId);
   void albumClicked(int albumId);
+  void albumOfflineClicked(int albumId);
 
 protected:
   bool eventFilter(QObject *obj, QEvent *event) override;
@@ -47,7 +47,7 @@ private:
   QVBoxLayout *albumsLayout;
 
   // Data
-  QJsonObject m_artistData;
+  Artist m_artist;
 
   void setupUI();
   void clearTopTracks();
@@ -4,9 +4,10 @@
 #include <QMenu>
 #include <QMouseEvent>
 #include <QVBoxLayout>
+#include <QtMath>
 
-FavoriteCard::FavoriteCard(const QJsonObject &trackData, QWidget *parent)
-    : QWidget(parent), m_trackData(trackData) {
+FavoriteCard::FavoriteCard(const Track &track, QWidget *parent)
+    : QWidget(parent), m_track(track) {
 
   setFixedSize(140, 220); // Increased dimensions for better readability
   setCursor(Qt::PointingHandCursor);
@@ -18,8 +19,7 @@ FavoriteCard::FavoriteCard(const QJsonObject &trackData, QWidget *parent)
 
   // Cover art (larger, square)
   coverLabel = new QLabel(this);
-  coverLabel->setFixedSize(120, 120);
-  coverLabel->setScaledContents(true);
+  coverLabel->setFixedSize(coverSize, coverSize);
   coverLabel->setStyleSheet("background-color: #282828; border-radius: 6px;");
   coverLabel->setAlignment(Qt::AlignCenter);
   coverLabel->setText("♪");
@@ -32,7 +32,7 @@ FavoriteCard::FavoriteCard(const QJsonObject &trackData, QWidget *parent)
   textLayout->setAlignment(Qt::AlignCenter); // Center text
 
   // Title
-  QString title = trackData["title"].toString();
+  QString title = track.title();
   titleLabel = new QLabel(title, this);
   titleLabel->setStyleSheet(
       "font-weight: bold; font-size: 14px; color: #fff;"); // Smaller font
@@ -42,7 +42,7 @@ FavoriteCard::FavoriteCard(const QJsonObject &trackData, QWidget *parent)
   titleLabel->setContentsMargins(4, 0, 4, 0); // Add padding
 
   // Artist
-  QString artist = trackData["artist"].toObject()["name"].toString();
+  QString artist = track.artistName();
 
   // Make artist name clickable
   artistLabel = new QPushButton(artist, this);
@@ -61,8 +61,7 @@ FavoriteCard::FavoriteCard(const QJsonObject &trackData, QWidget *parent)
                              "}");
 
   // Extract artist ID and connect signal
-  QJsonObject artistObj = trackData["artist"].toObject();
-  int artistId = artistObj["id"].toInt();
+  int artistId = track.artistId();
   qDebug() << "FavoriteCard: Artist" << artist << "ID:" << artistId;
 
   connect(artistLabel, &QPushButton::clicked, this, [this, artistId, artist]() {
@@ -119,8 +118,16 @@ FavoriteCard::FavoriteCard(const QJsonObject &trackData, QWidget *parent)
 
 void FavoriteCard::setCoverImage(const QPixmap &pixmap) {
   if (!pixmap.isNull()) {
-    coverLabel->setPixmap(
-        pixmap.scaled(120, 120, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+    // Thumbnails arrive at the exact device size; anything else is scaled
+    // once here rather than on every paint
+    qreal dpr = devicePixelRatioF();
+    int pixels = qCeil(coverSize * dpr);
+    QPixmap sized = pixmap.width() == pixels
+                        ? pixmap
+                        : pixmap.scaled(pixels, pixels, Qt::KeepAspectRatio,
+                                        Qt::SmoothTransformation);
+    sized.setDevicePixelRatio(dpr);
+    coverLabel->setPixmap(sized);
     coverLabel->setText("");
   }
 }
@@ -146,7 +153,7 @@ void FavoriteCard::mousePressEvent(QMouseEvent *event) {
 
     QAction *addToAlbumAction = contextMenu.addAction("Add to Album");
     connect(addToAlbumAction, &QAction::triggered, this,
-            [this]() { emit addToAlbumClicked(m_trackData); });
+            [this]() { emit addToAlbumClicked(m_track); });
 
     contextMenu.exec(event->globalPos());
   }
@@ -187,7 +194,7 @@ void FavoriteCard::setFavorite(bool isFavorite) {
                                     "}");
     unfavoriteButton->disconnect();
     connect(unfavoriteButton, &QPushButton::clicked, this,
-            [this]() { emit favoriteToggled(m_trackData, true); });
+            [this]() { emit favoriteToggled(m_track, true); });
   }
 }
 
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <QJsonObject>
+#include "../model/Track.hpp"
 #include <QLabel>
 #include <QPixmap>
 #include <QPushButton>
@@ -11,19 +11,19 @@ class FavoriteCard : public QWidget {
   Q_OBJECT
 
 public:
-  explicit FavoriteCard(const QJsonObject &trackData,
-                        QWidget *parent = nullptr);
+  explicit FavoriteCard(const Track &track, QWidget *parent = nullptr);
 
+  static constexpr int coverSize = 120; // Logical pixels, square
   void setCoverImage(const QPixmap &pixmap);
-  int getTrackId() const { return m_trackData["id"].toInt(); }
-  QJsonObject getTrackData() const { return m_trackData; }
+  int getTrackId() const { return m_track.id(); }
+  Track getTrack() const { return m_track; }
   void setFavorite(bool isFavorite);
 
 signals:
   void clicked(int trackId);
   void unfavoriteClicked(int trackId);
-  void addToAlbumClicked(const QJsonObject &track);
-  void favoriteToggled(const QJsonObject &track, bool isFavorite);
+  void addToAlbumClicked(const Track &track);
+  void favoriteToggled(const Track &track, bool isFavorite);
   void artistClicked(int artistId, const QString &artistName);
 
 protected:
@@ -32,7 +32,7 @@ protected:
   void leaveEvent(QEvent *event) override;
 
 private:
-  QJsonObject m_trackData;
+  Track m_track;
   QLabel *coverLabel;
   QLabel *titleLabel;
   QPushButton *artistLabel;
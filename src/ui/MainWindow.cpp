@@ -1,37 +1,61 @@
 #include "MainWindow.hpp"
+#include "../net/NetworkAccess.hpp"
 #include <QDebug>
 #include <QKeySequence>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
 #include <QPainter>
 #include <QPixmap>
+#include <QScrollBar>
 #include <QShortcut>
-#include <QStandardPaths>
+#include <QtMath>
 #include <QVBoxLayout>
 #include <QWidget>
 
 MainWindow::MainWindow(QWidget *parent)
-    : QMainWindow(parent), hifiClient(new HifiClient(this)),
-      player(new AudioPlayer(this)),
-      imageManager(new QNetworkAccessManager(this)),
-      downloadManager(new DownloadManager(this)) {
+    : QMainWindow(parent), hifiClient(new HifiClient),
+      player(new AudioPlayer(this)), downloadManager(new DownloadManager),
+      storageManager(new StorageManager(this)),
+      offlineSync(new OfflineSync(hifiClient, downloadManager, this)) {
+
+  // Network clients run on the I/O thread and answer through queued signals
+  QThread *ioThread = NetworkAccess::instance().ioThread();
+  hifiClient->moveToThread(ioThread);
+  downloadManager->moveToThread(ioThread);
+  connect(ioThread, &QThread::finished, hifiClient, &QObject::deleteLater);
+  connect(ioThread, &QThread::finished, downloadManager,
+          &QObject::deleteLater);
+
+  // Handshake with the first mirrors and the cover CDN while the UI is built,
+  // so the first search and cover skip connection setup
+  hifiClient->preconnect();
+  NetworkAccess::instance().preconnect({"https://resources.tidal.com"});
 
   connect(downloadManager, &DownloadManager::downloadFinished, this,
           &MainWindow::onDownloadFinished);
+  connect(downloadManager, &DownloadManager::downloadProgress, this,
+          [this](int trackId, qint64 received, qint64 total) {
+            if (total <= 0)
+              return;
+            statusLabel->setText(
+                QString("Downloading track %1: %2%")
+                    .arg(trackId)
+                    .arg(received * 100 / total));
+          });
   connect(downloadManager, &DownloadManager::coverDownloadFinished, this,
-          [this](int trackId, const QString &coverPath) {
-            DatabaseManager::instance().updateCoverPath(trackId, coverPath);
-            // Refresh card if it exists
-            for (auto *card : favoriteCards) {
-              if (card->getTrackId() == trackId) {
-                QPixmap pixmap(coverPath);
-                if (!pixmap.isNull()) {
-                  card->setCoverImage(pixmap);
-                }
-                break;
-              }
-            }
+          &MainWindow::onCoverStored);
+  // Signed stream URLs expire; fetch a fresh one and resume from the .part
+  connect(downloadManager, &DownloadManager::streamUrlExpired, this,
+          [this](int trackId) {
+            if (offlineSync->isSyncing(trackId))
+              return; // It resolves its own
+            pendingDownloadStreams.insert(trackId);
+            hifiClient->getTrackStream(trackId);
           });
+  // Pick up downloads interrupted by the last exit or a lost connection
+  DatabaseManager::instance()
+      .read([]() { return DatabaseManager::instance().getQueuedDownloads(); })
+      .then(this, [this](const QList<QueuedDownload> &queued) {
+        downloadManager->restoreQueue(queued);
+      });
 
   connect(player, &AudioPlayer::playbackFinished, this,
           &MainWindow::onNextClicked);
@@ -54,6 +78,8 @@ MainWindow::MainWindow(QWidget *parent)
   searchBox->setPlaceholderText("Search for tracks...");
   searchBox->setMinimumWidth(400);
   searchButton = new QPushButton("Search");
+  searchDebounce = new QTimer(this);
+  searchDebounce->setSingleShot(true);
   searchLayout->addWidget(searchBox);
   searchLayout->addWidget(searchButton);
   searchLayout->addStretch();
@@ -73,14 +99,19 @@ MainWindow::MainWindow(QWidget *parent)
   favouritesScrollArea = new QScrollArea();
   favouritesScrollArea->setWidgetResizable(true);
   favouritesScrollArea->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-  favouritesScrollArea->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-  // No height limit - show all tracks
+  // Scrolls down through favorites, which are read a page at a time
+  favouritesScrollArea->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
   favouritesScrollArea->setStyleSheet(
       "QScrollArea { background-color: #121212; border: none; }"
       "QScrollBar:horizontal { height: 8px; background: #282828; }"
       "QScrollBar::handle:horizontal { background: #535353; border-radius: "
       "4px; }"
       "QScrollBar::add-line:horizontal, QScrollBar::sub-line:horizontal { "
+      "border: none; background: none; }"
+      "QScrollBar:vertical { width: 8px; background: #282828; }"
+      "QScrollBar::handle:vertical { background: #535353; border-radius: "
+      "4px; }"
+      "QScrollBar::add-line:vertical, QScrollBar::sub-line:vertical { "
       "border: none; background: none; }");
 
   favouritesContainer = new QWidget();
@@ -249,10 +280,9 @@ MainWindow::MainWindow(QWidget *parent)
     // if available. For now, let's look at onTrackSelected to see where we have
     // the info.
     if (currentTrackId != -1 && trackCache.contains(currentTrackId)) {
-      QJsonObject track = trackCache[currentTrackId];
-      QJsonObject artist = track["artist"].toObject();
-      int artistId = artist["id"].toInt();
-      QString artistName = artist["name"].toString();
+      const Track &track = trackCache[currentTrackId];
+      int artistId = track.artistId();
+      QString artistName = track.artistName();
       qDebug() << "MainWindow: Navigating to artist:" << artistName
                << "ID:" << artistId;
       onArtistClicked(artistId, artistName);
@@ -369,6 +399,61 @@ MainWindow::MainWindow(QWidget *parent)
   seekSlider->setStyleSheet(seekSliderStyle);
 
   statusLabel = new QLabel("Ready", this);
+  connect(storageManager, &StorageManager::usageChanged, this,
+          [this](const StorageUsage &usage) {
+            storageTip =
+                QString("Downloads: %1 of %2 MB\nFavorites: %3 of %4 MB\n"
+                        "Covers: %5 of %6 MB\nPlayback: %7 of %8 MB")
+                    .arg(usage.downloadBytes >> 20)
+                    .arg(usage.downloadQuota >> 20)
+                    .arg(usage.favoriteBytes >> 20)
+                    .arg(usage.favoriteQuota >> 20)
+                    .arg(usage.coverBytes >> 20)
+                    .arg(usage.coverQuota >> 20)
+                    .arg(usage.playbackBytes >> 20)
+                    .arg(usage.playbackQuota >> 20);
+            updateStatusTip();
+          });
+  connect(hifiClient, &HifiClient::statsChanged, this,
+          [this](const HifiClient::RequestStats &stats,
+                 const QList<RetryPolicy::MirrorStatus> &mirrors) {
+            QStringList unavailable;
+            for (const RetryPolicy::MirrorStatus &mirror : mirrors) {
+              if (mirror.state != RetryPolicy::Closed)
+                unavailable.append(QUrl(mirror.mirror).host());
+            }
+            networkTip =
+                QString("Requests: %1 sent, %2 joined, %3 retried, "
+                        "%4 given up\nMirrors: %5 of %6 available")
+                    .arg(stats.issued)
+                    .arg(stats.coalesced)
+                    .arg(stats.retried)
+                    .arg(stats.abandoned)
+                    .arg(mirrors.size() - unavailable.size())
+                    .arg(mirrors.size());
+            if (!unavailable.isEmpty())
+              networkTip += " (down: " + unavailable.join(", ") + ")";
+            updateStatusTip();
+          });
+  connect(offlineSync, &OfflineSync::progress, this,
+          [this](int done, int total, int etaSecs) {
+            QString text =
+                QString("Offline sync: %1 of %2 tracks").arg(done).arg(total);
+            if (etaSecs >= 0)
+              text += QString(", about %1:%2 left")
+                          .arg(etaSecs / 60)
+                          .arg(etaSecs % 60, 2, 10, QChar('0'));
+            statusLabel->setText(text);
+          });
+  connect(offlineSync, &OfflineSync::finished, this,
+          [this](int downloaded, int failed) {
+            statusLabel->setText(
+                QString("Offline sync done: %1 downloaded, %2 failed")
+                    .arg(downloaded)
+                    .arg(failed));
+          });
+  // Clear out what the last session left over quota
+  storageManager->scheduleCompaction();
 
   // Content layout (page stack + cover)
   // Content layout (page stack + cover area)
@@ -433,49 +518,61 @@ MainWindow::MainWindow(QWidget *parent)
           &MainWindow::onSearchClicked);
   connect(searchBox, &QLineEdit::returnPressed, this,
           &MainWindow::onSearchClicked);
+  connect(searchBox, &QLineEdit::textEdited, this,
+          &MainWindow::onSearchTextEdited);
+  connect(searchDebounce, &QTimer::timeout, this,
+          &MainWindow::onSearchClicked);
   connect(playPauseButton, &QPushButton::clicked, this,
           &MainWindow::onPlayPauseClicked);
   connect(prevButton, &QPushButton::clicked, this, &MainWindow::onPrevClicked);
   connect(nextButton, &QPushButton::clicked, this, &MainWindow::onNextClicked);
 
   connect(hifiClient, &HifiClient::searchResults, this,
-          [this](const QJsonArray &tracks) {
-            resultsList->clear();
-            trackCache.clear();
-
-            // Switch to search results page
-            pageStack->setCurrentIndex(1);
-
-            if (!tracks.isEmpty()) {
-              QJsonObject first = tracks[0].toObject();
-              QString title = first["title"].toString();
-              QString artist = first["artist"].toObject()["name"].toString();
-              statusLabel->setText("Found: " + title + " by " + artist);
+          [this](const QString &query, int offset, int total,
+                 const QList<Track> &tracks) {
+            if (offset > 0) {
+              // A further page of the listing already on screen
+              searchPageLoading = false;
+              if (query != cachedResultsQuery || offset != cachedResults.size())
+                return;
+
+              // Mirrors that ignore offset resend the first page
+              QSet<int> known;
+              for (const Track &track : cachedResults)
+                known.insert(track.id());
+              QList<Track> fresh;
+              for (const Track &track : tracks) {
+                if (!known.contains(track.id()))
+                  fresh.append(track);
+              }
+              cachedResults += fresh;
+              searchTotal = fresh.isEmpty() ? cachedResults.size() : total;
+              appendSearchResults(fresh);
+              return;
+            }
+
+            searchInFlightQuery.clear();
+
+            // Failed searches also come back empty; never refine from those
+            if (tracks.isEmpty()) {
+              cachedResultsQuery.clear();
+              cachedResults.clear();
+              searchTotal = 0;
             } else {
-              statusLabel->setText("No results found.");
+              cachedResultsQuery = query;
+              cachedResults = tracks;
+              searchTotal = total;
             }
 
-            for (const auto &val : tracks) {
-              QJsonObject track = val.toObject();
-              int id = track["id"].toInt();
-              trackCache.insert(id, track);
-
-              QListWidgetItem *item = new QListWidgetItem(resultsList);
-              item->setSizeHint(QSize(0, 50)); // Set height for custom widget
-              item->setData(Qt::UserRole, id); // Store ID for playback
-
-              TrackItemWidget *widget = new TrackItemWidget(
-                  track, DatabaseManager::instance().isFavorite(id));
-              connect(widget, &TrackItemWidget::favoriteToggled, this,
-                      [this, track](bool isFav) {
-                        onFavoriteToggled(track, isFav);
-                      });
-              connect(widget, &TrackItemWidget::addToAlbumClicked, this,
-                      [this, track]() { onAddToAlbumClicked(track); });
-              connect(widget, &TrackItemWidget::artistClicked, this,
-                      &MainWindow::onArtistClicked);
-
-              resultsList->setItemWidget(item, widget);
+            // The user may have kept typing while this was in flight
+            QString current = searchBox->text().trimmed();
+            if (current.isEmpty())
+              return;
+            if (!tracks.isEmpty() &&
+                current.startsWith(query, Qt::CaseInsensitive)) {
+              showSearchResults(filterCachedResults(current));
+            } else {
+              showSearchResults(tracks);
             }
           });
 
@@ -484,22 +581,53 @@ MainWindow::MainWindow(QWidget *parent)
           &MainWindow::onTrackStreamUrl);
   connect(hifiClient, &HifiClient::errorOccurred, this,
           &MainWindow::onApiError); // Changed client to hifiClient
+  // Nothing will arrive for a track whose stream URL failed
+  connect(hifiClient, &HifiClient::trackStreamFailed, this,
+          [this](int trackId) {
+            pendingDownloadStreams.remove(trackId);
+            if (trackId == pendingPlaybackTrackId)
+              pendingPlaybackTrackId = -1;
+          });
 
   // Artist profile signals
   connect(hifiClient, &HifiClient::artistLoaded, this,
-          [this](const QJsonObject &artistData) {
-            qDebug() << "MainWindow: Artist loaded:" << artistData;
-            artistPage->setArtistData(artistData);
+          [this](const Artist &artist) {
+            qDebug() << "MainWindow: Artist loaded:" << artist.name;
+            artistPage->setArtistData(artist);
             statusLabel->setText("Loaded artist profile");
           });
   connect(
       hifiClient, &HifiClient::artistTopTracksLoaded, this,
-      [this](const QJsonArray &tracks) { artistPage->setTopTracks(tracks); });
+      [this](const QList<Track> &tracks) { artistPage->setTopTracks(tracks); });
+  connect(hifiClient, &HifiClient::albumLoaded, this,
+          &MainWindow::onAlbumLoaded);
+  connect(hifiClient, &HifiClient::albumFailed, this, [this](int albumId) {
+    if (pendingOfflineAlbums.remove(albumId))
+      statusLabel->setText("Could not load album for offline sync");
+  });
+  connect(artistPage, &ArtistProfilePage::albumOfflineClicked, this,
+          [this](int albumId) {
+            statusLabel->setText("Loading album for offline sync...");
+            pendingOfflineAlbums.insert(albumId);
+            hifiClient->getAlbum(albumId);
+          });
   connect(hifiClient, &HifiClient::artistAlbumsLoaded, this,
-          [this](const QJsonArray &albums) { artistPage->setAlbums(albums); });
+          [this](const QList<Album> &albums) { artistPage->setAlbums(albums); });
 
   connect(resultsList, &QListWidget::itemDoubleClicked, this,
           &MainWindow::onTrackSelected);
+  connect(resultsList->verticalScrollBar(), &QScrollBar::valueChanged, this,
+          &MainWindow::fetchNextResultPage);
+  // A new page may still not fill the view, so look again once it is laid
+  // out
+  QScrollBar *favoritesBar = favouritesScrollArea->verticalScrollBar();
+  connect(favoritesBar, &QScrollBar::valueChanged, this,
+          &MainWindow::fetchNextFavoritesPage);
+  connect(favoritesBar, &QScrollBar::rangeChanged, this,
+          &MainWindow::fetchNextFavoritesPage);
+  // Paging stops while the grid is hidden
+  connect(pageStack, &QStackedWidget::currentChanged, this,
+          &MainWindow::fetchNextFavoritesPage);
 
   connect(player, &AudioPlayer::positionChanged, this,
           &MainWindow::onPositionChanged);
@@ -517,9 +645,6 @@ MainWindow::MainWindow(QWidget *parent)
   connect(seekSlider, &QSlider::sliderReleased, this,
           &MainWindow::onSeekSliderReleased);
 
-  connect(imageManager, &QNetworkAccessManager::finished, this,
-          &MainWindow::onCoverImageDownloaded);
-
   connect(volumeSlider, &QSlider::valueChanged,
           this, // Changed lambda to method call
           &MainWindow::onVolumeChanged);
@@ -550,7 +675,8 @@ MainWindow::MainWindow(QWidget *parent)
 }
 
 void MainWindow::onSearchClicked() {
-  QString query = searchBox->text();
+  searchDebounce->stop();
+  QString query = searchBox->text().trimmed();
   if (query.isEmpty()) {
     pageStack->setCurrentIndex(0); // Go back to Home
     statusLabel->setText("Ready");
@@ -558,16 +684,177 @@ void MainWindow::onSearchClicked() {
   }
 
   statusLabel->setText("Searching...");
+  searchInFlightQuery = query;
+  searchPageLoading = false; // Any page request is superseded
   hifiClient->searchTracks(query);
 }
 
+void MainWindow::onSearchTextEdited(const QString &text) {
+  QString query = text.trimmed();
+  if (query.isEmpty()) {
+    searchDebounce->stop();
+    hifiClient->cancelPendingSearch();
+    searchInFlightQuery.clear();
+    searchPageLoading = false;
+    pageStack->setCurrentIndex(0);
+    statusLabel->setText("Ready");
+    return;
+  }
+
+  // A search the text no longer extends cannot be reused; drop it now
+  if (!searchInFlightQuery.isEmpty() &&
+      !query.startsWith(searchInFlightQuery, Qt::CaseInsensitive)) {
+    hifiClient->cancelPendingSearch();
+    searchInFlightQuery.clear();
+    searchPageLoading = false;
+  }
+
+  // Refine the previous results instantly while the longer query is fetched
+  if (!cachedResultsQuery.isEmpty() &&
+      query.startsWith(cachedResultsQuery, Qt::CaseInsensitive)) {
+    QList<Track> refined = filterCachedResults(query);
+    showSearchResults(refined);
+    if (query.compare(cachedResultsQuery, Qt::CaseInsensitive) == 0) {
+      searchDebounce->stop(); // Back at the query we already have
+      return;
+    }
+    if (refined.isEmpty())
+      statusLabel->setText("Searching...");
+  }
+
+  // Single characters match too broadly to be worth a request
+  if (query.size() < 2) {
+    searchDebounce->stop();
+    return;
+  }
+
+  // Wait for a pause in typing. Each superseded request costs a mirror round
+  // trip, so slower mirrors get a longer pause.
+  int latency = hifiClient->searchLatency();
+  searchDebounce->start(latency == 0 ? 300 : qBound(150, latency / 2, 600));
+}
+
+QList<Track> MainWindow::filterCachedResults(const QString &query) const {
+  const QStringList terms = query.split(' ', Qt::SkipEmptyParts);
+  QList<Track> matches;
+  for (const Track &track : cachedResults) {
+    QString text = track.title() + ' ' + track.artistName() + ' ' +
+                   track.albumTitle();
+    bool matchesAll = true;
+    for (const QString &term : terms) {
+      if (!text.contains(term, Qt::CaseInsensitive)) {
+        matchesAll = false;
+        break;
+      }
+    }
+    if (matchesAll)
+      matches.append(track);
+  }
+  return matches;
+}
+
+void MainWindow::showSearchResults(const QList<Track> &tracks) {
+  resultsList->clear();
+  trackCache.clear();
+
+  // Switch to search results page
+  pageStack->setCurrentIndex(1);
+
+  if (!tracks.isEmpty()) {
+    const Track &first = tracks.first();
+    QString title = first.title();
+    QString artist = first.artistName();
+    statusLabel->setText("Found: " + title + " by " + artist);
+  } else {
+    statusLabel->setText("No results found.");
+  }
+
+  // The first screenful is built right away, the rest in later batches
+  pendingResultRows = tracks;
+  renderResultBatch();
+}
+
+void MainWindow::appendSearchResults(const QList<Track> &tracks) {
+  // Refined views are local filters and do not page
+  if (searchBox->text().trimmed().compare(cachedResultsQuery,
+                                          Qt::CaseInsensitive) != 0)
+    return;
+
+  statusLabel->setText(QString("Showing %1 of %2 results")
+                           .arg(cachedResults.size())
+                           .arg(searchTotal));
+  pendingResultRows += tracks;
+  renderResultBatch();
+}
+
+void MainWindow::renderResultBatch() {
+  // Row widgets are costly to build; yield to the event loop between batches
+  // so typing, scrolling and playback stay responsive
+  const int batchSize = 10;
+  for (int i = 0; i < batchSize && !pendingResultRows.isEmpty(); ++i)
+    addResultRow(pendingResultRows.takeFirst());
+
+  if (!pendingResultRows.isEmpty()) {
+    if (!resultBatchScheduled) {
+      resultBatchScheduled = true;
+      QTimer::singleShot(0, this, [this]() {
+        resultBatchScheduled = false;
+        renderResultBatch();
+      });
+    }
+    return;
+  }
+
+  // A short first page may not fill the view; keep going until it does
+  fetchNextResultPage();
+}
+
+void MainWindow::addResultRow(const Track &track) {
+  int id = track.id();
+  trackCache.insert(id, track);
+
+  QListWidgetItem *item = new QListWidgetItem(resultsList);
+  item->setSizeHint(QSize(0, 50)); // Set height for custom widget
+  item->setData(Qt::UserRole, id); // Store ID for playback
+
+  TrackItemWidget *widget =
+      new TrackItemWidget(track, DatabaseManager::instance().isFavorite(id));
+  connect(widget, &TrackItemWidget::favoriteToggled, this,
+          [this, track](bool isFav) { onFavoriteToggled(track, isFav); });
+  connect(widget, &TrackItemWidget::addToAlbumClicked, this,
+          [this, track]() { onAddToAlbumClicked(track); });
+  connect(widget, &TrackItemWidget::artistClicked, this,
+          &MainWindow::onArtistClicked);
+
+  resultsList->setItemWidget(item, widget);
+}
+
+void MainWindow::fetchNextResultPage() {
+  if (searchPageLoading || !pendingResultRows.isEmpty() ||
+      cachedResults.size() >= searchTotal ||
+      pageStack->currentWidget() != searchPage)
+    return;
+  if (searchBox->text().trimmed().compare(cachedResultsQuery,
+                                          Qt::CaseInsensitive) != 0)
+    return;
+
+  // Prefetch once the user is within a screen of the end
+  QScrollBar *bar = resultsList->verticalScrollBar();
+  if (bar->maximum() - bar->value() > bar->pageStep())
+    return;
+
+  searchPageLoading = true;
+  statusLabel->setText("Loading more results...");
+  hifiClient->searchTracks(cachedResultsQuery, cachedResults.size());
+}
+
 void MainWindow::onTrackSelected(QListWidgetItem *item) {
   int trackId = item->data(Qt::UserRole).toInt();
 
   if (trackCache.contains(trackId)) {
-    QJsonObject track = trackCache[trackId];
-    QString title = track["title"].toString();
-    QString artist = track["artist"].toObject()["name"].toString();
+    const Track &track = trackCache[trackId];
+    QString title = track.title();
+    QString artist = track.artistName();
 
     statusLabel->setText("Fetching stream for: " + title + " by " + artist);
 
@@ -581,26 +868,14 @@ void MainWindow::onTrackSelected(QListWidgetItem *item) {
     // Store current track ID for artist navigation
     currentTrackId = trackId;
 
-    // Fetch cover for the selected track
-    if (track.contains("album")) {
-      QJsonObject album = track["album"].toObject();
-      if (album.contains("cover")) {
-        QString coverId = album["cover"].toString();
-        if (!coverId.isEmpty()) {
-          QString coverUrl =
-              QString("https://resources.tidal.com/images/%1/640x640.jpg")
-                  .arg(coverId.replace("-", "/"));
-          imageManager->get(QNetworkRequest(QUrl(coverUrl)));
-        } else {
-          qDebug() << "Track" << trackId << "album has empty cover ID.";
-          coverLabel->hide();
-        }
-      } else {
-        qDebug() << "Track" << trackId << "album has no 'cover' field.";
-        coverLabel->hide();
-      }
+    // Fetch cover for the selected track, from the store if it is there
+    QString coverId = track.cover();
+    if (!coverId.isEmpty()) {
+      pendingCoverId = coverId;
+      downloadManager->downloadCover(coverId, coverPixels(coverLabel->width()),
+                                     TransferScheduler::Interactive);
     } else {
-      qDebug() << "Track" << trackId << "has no 'album' field.";
+      qDebug() << "Track" << trackId << "album has empty cover ID.";
       coverLabel->hide();
     }
   } else {
@@ -619,19 +894,32 @@ void MainWindow::onTrackSelected(QListWidgetItem *item) {
     }
   }
 
-  // Check if we have a local file for this track
-  QString localPath = DatabaseManager::instance().getFilePath(trackId);
-  if (!localPath.isEmpty() && QFile::exists(localPath)) {
-    statusLabel->setText("Playing from local cache...");
-    player->playUrl(QUrl::fromLocalFile(localPath).toString());
-    playPauseButton->setIcon(style()->standardIcon(QStyle::SP_MediaPause));
-    // Show cover
-    if (!coverLabel->pixmap().isNull()) {
-      coverLabel->setVisible(true);
-    }
-  } else {
-    hifiClient->getTrackStream(trackId);
-  }
+  // Look for a local file off the GUI thread, then play it or stream
+  int generation = ++playbackGeneration;
+  DatabaseManager::instance()
+      .read([trackId]() {
+        QString localPath = DatabaseManager::instance().getFilePath(trackId);
+        return QFile::exists(localPath) ? localPath : QString();
+      })
+      .then(this, [this, trackId, generation](const QString &localPath) {
+        if (generation != playbackGeneration)
+          return; // Another track was picked meanwhile
+        if (!localPath.isEmpty()) {
+          statusLabel->setText("Playing from local cache...");
+          player->playUrl(QUrl::fromLocalFile(localPath).toString());
+          DatabaseManager::instance().recordPlayAsync(trackId);
+          playPauseButton->setIcon(
+              style()->standardIcon(QStyle::SP_MediaPause));
+          // Show cover
+          if (!coverLabel->pixmap().isNull()) {
+            coverLabel->setVisible(true);
+          }
+          pendingPlaybackTrackId = -1;
+        } else {
+          pendingPlaybackTrackId = trackId;
+          hifiClient->getTrackStream(trackId);
+        }
+      });
 }
 
 void MainWindow::onAddAlbumClicked() {
@@ -641,18 +929,39 @@ void MainWindow::onAddAlbumClicked() {
     QString coverPath = dialog.getCoverPath();
 
     if (!name.isEmpty()) {
-      int albumId = DatabaseManager::instance().createAlbum(name, coverPath);
-      if (albumId != -1) {
-        statusLabel->setText("Album created: " + name);
-        refreshAlbumsList();
-      } else {
-        statusLabel->setText("Failed to create album");
-      }
+      DatabaseManager::instance()
+          .createAlbumAsync(name, coverPath)
+          .then(this, [this, name](int albumId) {
+            if (albumId != -1) {
+              statusLabel->setText("Album created: " + name);
+              refreshAlbumsList();
+            } else {
+              statusLabel->setText("Failed to create album");
+            }
+          });
     }
   }
 }
 
 void MainWindow::refreshAlbumsList() {
+  // Read off the GUI thread; only the newest request fills the row
+  int generation = ++albumsGeneration;
+  DatabaseManager::instance()
+      .read([]() {
+        DatabaseManager &db = DatabaseManager::instance();
+        // Covers for every composite at once, not a query per album
+        return qMakePair(db.getAlbums(), db.getAlbumCoverIds(4));
+      })
+      .then(this, [this, generation](
+                      const QPair<QList<Album>, QHash<int, QStringList>>
+                          &result) {
+        if (generation == albumsGeneration)
+          showAlbums(result.first, result.second);
+      });
+}
+
+void MainWindow::showAlbums(const QList<Album> &albums,
+                            const QHash<int, QStringList> &trackCovers) {
   // Clear existing cards
   QLayoutItem *child;
   while ((child = albumsContainer->layout()->takeAt(0)) != nullptr) {
@@ -661,27 +970,27 @@ void MainWindow::refreshAlbumsList() {
   }
   albumCards.clear();
 
-  QList<QJsonObject> albums = DatabaseManager::instance().getAlbums();
-  for (const QJsonObject &album : albums) {
+  for (const Album &album : albums) {
     AlbumCard *card = new AlbumCard(album);
     // Ensure card has a reasonable width for horizontal layout
     card->setFixedWidth(200);
     connect(card, &AlbumCard::clicked, this, &MainWindow::onAlbumCardClicked);
     connect(card, &AlbumCard::deleteClicked, this,
             &MainWindow::onAlbumDeleteClicked);
+    connect(card, &AlbumCard::offlineClicked, this,
+            &MainWindow::onAlbumOfflineClicked);
     albumsContainer->layout()->addWidget(card);
-    albumCards.insert(album["id"].toInt(), card);
+    albumCards.insert(album.id, card);
 
     // Check if album has a cover path
-    if (album.contains("coverPath") &&
-        !album["coverPath"].toString().isEmpty()) {
-      QPixmap pixmap(album["coverPath"].toString());
+    if (!album.coverPath.isEmpty()) {
+      QPixmap pixmap(album.coverPath);
       if (!pixmap.isNull()) {
         card->setCoverImage(pixmap);
       }
     } else {
       // Generate composite cover from track covers
-      generateAlbumCoverGrid(album["id"].toInt(), card);
+      generateAlbumCoverGrid(trackCovers.value(album.id), card);
     }
   }
 }
@@ -692,10 +1001,23 @@ void MainWindow::onAlbumCardClicked(int albumId) {
   // Find the album name
   QString albumName = "Unknown Album";
   if (albumCards.contains(albumId)) {
-    albumName = albumCards[albumId]->getAlbumData()["title"].toString();
+    albumName = albumCards[albumId]->getAlbum().title;
   }
   albumTitleLabel->setText(albumName);
 
+  pageStack->setCurrentIndex(2); // Album View
+  statusLabel->setText("Viewing album: " + albumName);
+
+  // Filled in once read, unless another album was opened meanwhile
+  int generation = ++albumTracksGeneration;
+  DatabaseManager::instance().getAlbumTracksAsync(albumId).then(
+      this, [this, generation](const QList<Track> &tracks) {
+        if (generation == albumTracksGeneration)
+          showAlbumTracks(tracks);
+      });
+}
+
+void MainWindow::showAlbumTracks(const QList<Track> &tracks) {
   // Clear existing cards
   QLayoutItem *child;
   while ((child = albumTracksGrid->layout()->takeAt(0)) != nullptr) {
@@ -710,9 +1032,6 @@ void MainWindow::onAlbumCardClicked(int albumId) {
                 // But wait, if we play a track, we might want to update UI.
                 // For now, let's just create them and relying on signals.
 
-  QList<QJsonObject> tracks =
-      DatabaseManager::instance().getAlbumTracks(albumId);
-
   if (tracks.isEmpty()) {
     // Show empty state?
     QLabel *emptyLabel =
@@ -726,24 +1045,23 @@ void MainWindow::onAlbumCardClicked(int albumId) {
     int col = 0;
     int maxCols = 6; // Responsive? Fixed for now.
 
-    for (const QJsonObject &track : tracks) {
-      int trackId = track["id"].toInt();
+    // The full list of IDs for this album context, shared by every card
+    QList<int> albumTrackIds;
+    for (const auto &t : tracks)
+      albumTrackIds.append(t.id());
+
+    for (const Track &track : tracks) {
+      int trackId = track.id();
       trackCache.insert(trackId, track); // Add to cache for playback
 
       // Use FavoriteCard for consistency
       FavoriteCard *card = new FavoriteCard(track, albumTracksContainer);
 
-      // Check actual favorite status
+      // Check actual favorite status; answered from memory
       bool isFav = DatabaseManager::instance().isFavorite(trackId);
       card->setFavorite(isFav);
 
       // Connect signals
-      // Connect signals
-      // Capture the full list of IDs for this album context
-      QList<int> albumTrackIds;
-      for (const auto &t : tracks)
-        albumTrackIds.append(t["id"].toInt());
-
       connect(card, &FavoriteCard::clicked, this,
               [this, trackId, albumTrackIds]() {
                 currentPlaylist = albumTrackIds;
@@ -761,26 +1079,28 @@ void MainWindow::onAlbumCardClicked(int albumId) {
                 onFavoriteToggled(track, false);
               });
       connect(card, &FavoriteCard::favoriteToggled, this,
-              [this, track](const QJsonObject &, bool isFav) {
+              [this, track](const Track &, bool isFav) {
                 // This toggles track on/off from favorites
+                QFuture<bool> stored;
                 if (!isFav) {
-                  DatabaseManager::instance().removeFavorite(
-                      track["id"].toInt());
+                  downloadManager->cancelTrack(track.id());
+                  offlineSync->cancelTrack(track.id());
+                  stored = DatabaseManager::instance().removeFavoriteAsync(
+                      track.id());
+                  storageManager->scheduleCompaction(); // Prunes its cover
                 } else {
-                  DatabaseManager::instance().addFavorite(track);
+                  stored = DatabaseManager::instance().addFavoriteAsync(track);
                 }
-                refreshFavoritesList(); // Refresh favorites if in home view
+                // Refresh favorites if in home view
+                stored.then(this, [this](bool) { refreshFavoritesList(); });
               });
       connect(card, &FavoriteCard::artistClicked, this,
               &MainWindow::onArtistClicked);
 
       // Check if we have a cover image for this track
-      QString coverPath = DatabaseManager::instance().getCoverPath(trackId);
-      if (!coverPath.isEmpty()) {
-        QPixmap pixmap(coverPath);
-        if (!pixmap.isNull()) {
-          card->setCoverImage(pixmap);
-        }
+      QPixmap pixmap = storedCover(track.cover(), FavoriteCard::coverSize);
+      if (!pixmap.isNull()) {
+        card->setCoverImage(pixmap);
       } else {
         // Trigger download if needed?
         // MainWindow::onFavoriteCardClicked handles playback, but cover loading
@@ -797,26 +1117,39 @@ void MainWindow::onAlbumCardClicked(int albumId) {
       }
     }
   }
-
-  pageStack->setCurrentIndex(2); // Album View
-  statusLabel->setText("Viewing album: " + albumName);
 }
 
-void MainWindow::onAddToAlbumClicked(const QJsonObject &track) {
+void MainWindow::onAddToAlbumClicked(const Track &track) {
   // Get list of albums
-  QList<QJsonObject> albums = DatabaseManager::instance().getAlbums();
+  DatabaseManager::instance()
+      .read([]() { return DatabaseManager::instance().getAlbums(); })
+      .then(this, [this, track](const QList<Album> &albums) {
+        chooseAlbumFor(track, albums);
+      });
+}
 
+void MainWindow::chooseAlbumFor(const Track &track,
+                                const QList<Album> &albums) {
   if (albums.isEmpty()) {
     statusLabel->setText("No albums found. Create an album first!");
     return;
   }
 
-  // Create list of album names for the dialog
+  // Create list of album names for the dialog, leaving out the albums the
+  // track is in already (answered from memory)
+  const QList<int> containing =
+      DatabaseManager::instance().albumsWithTrack(track.id());
   QStringList albumNames;
   QList<int> albumIds;
-  for (const QJsonObject &album : albums) {
-    albumNames.append(album["title"].toString());
-    albumIds.append(album["id"].toInt());
+  for (const Album &album : albums) {
+    if (containing.contains(album.id))
+      continue;
+    albumNames.append(album.title);
+    albumIds.append(album.id);
+  }
+  if (albumNames.isEmpty()) {
+    statusLabel->setText("\"" + track.title() + "\" is in every album");
+    return;
   }
 
   // Show selection dialog
@@ -830,38 +1163,34 @@ void MainWindow::onAddToAlbumClicked(const QJsonObject &track) {
     if (index >= 0) {
       int albumId = albumIds[index];
 
-      // Add track to album
-      bool success =
-          DatabaseManager::instance().addTrackToAlbum(albumId, track);
-
-      if (success) {
-        QString trackTitle = track["title"].toString();
-        statusLabel->setText("Added \"" + trackTitle + "\" to " + selected);
-
-        // Check if we need to download the cover
-        int trackId = track["id"].toInt();
-        QString existingCover =
-            DatabaseManager::instance().getCoverPath(trackId);
-        if (existingCover.isEmpty()) {
-          if (track.contains("album")) {
-            QJsonObject album = track["album"].toObject();
-            if (album.contains("cover")) {
-              QString coverId = album["cover"].toString();
-              if (!coverId.isEmpty()) {
-                QString coverUrl =
-                    QString("https://resources.tidal.com/images/%1/640x640.jpg")
-                        .arg(coverId.replace("-", "/"));
-                downloadManager->downloadCover(coverUrl, trackId);
-              }
+      // Add track to album on the DB thread, which also checks for a
+      // stored cover
+      DatabaseManager::instance()
+          .write([albumId, track]() {
+            DatabaseManager &db = DatabaseManager::instance();
+            bool added = db.addTrackToAlbum(albumId, track);
+            return qMakePair(added, !db.isCoverStored(track.cover()));
+          })
+          .then(this, [this, track, selected](QPair<bool, bool> result) {
+            auto [success, coverMissing] = result;
+            if (!success) {
+              statusLabel->setText("Failed to add track to album");
+              return;
+            }
+            QString trackTitle = track.title();
+            statusLabel->setText("Added \"" + trackTitle + "\" to " +
+                                 selected);
+
+            // Check if we need to download the cover
+            QString coverId = track.cover();
+            if (coverMissing && !coverId.isEmpty()) {
+              downloadManager->downloadCover(
+                  coverId, coverPixels(FavoriteCard::coverSize));
             }
-          }
-        }
 
-        // Refresh albums list to update cover if needed
-        refreshAlbumsList();
-      } else {
-        statusLabel->setText("Failed to add track to album");
-      }
+            // Refresh albums list to update cover if needed
+            refreshAlbumsList();
+          });
     }
   }
 }
@@ -870,7 +1199,7 @@ void MainWindow::onAlbumDeleteClicked(int albumId) {
   // Find album name for confirmation
   QString albumName = "Unknown Album";
   if (albumCards.contains(albumId)) {
-    albumName = albumCards[albumId]->getAlbumData()["title"].toString();
+    albumName = albumCards[albumId]->getAlbum().title;
   }
 
   // First confirmation dialog
@@ -893,40 +1222,32 @@ void MainWindow::onAlbumDeleteClicked(int albumId) {
 
   if (reply == QMessageBox::Yes) {
     // Perform deletion
-    bool success = DatabaseManager::instance().deleteAlbum(albumId);
-
-    if (success) {
-      statusLabel->setText("Deleted album: " + albumName);
-      refreshAlbumsList(); // Refresh to remove from UI
-    } else {
-      statusLabel->setText("Failed to delete album");
-      QMessageBox::critical(this, "Error",
-                            "Failed to delete the album from the database.");
-    }
+    DatabaseManager::instance().deleteAlbumAsync(albumId).then(
+        this, [this, albumName](bool success) {
+          if (success) {
+            statusLabel->setText("Deleted album: " + albumName);
+            refreshAlbumsList(); // Refresh to remove from UI
+            storageManager->scheduleCompaction(); // Prunes its covers
+          } else {
+            statusLabel->setText("Failed to delete album");
+            QMessageBox::critical(
+                this, "Error",
+                "Failed to delete the album from the database.");
+          }
+        });
   }
 }
 
-void MainWindow::generateAlbumCoverGrid(int albumId, AlbumCard *card) {
-  QList<QJsonObject> tracks =
-      DatabaseManager::instance().getAlbumTracks(albumId);
-
-  if (tracks.isEmpty()) {
-    return; // No tracks, use default cover
-  }
-
+void MainWindow::generateAlbumCoverGrid(const QStringList &coverIds,
+                                        AlbumCard *card) {
   // Collect up to 4 covers
   QList<QPixmap> covers;
-  for (const QJsonObject &track : tracks) {
+  for (const QString &coverId : coverIds) {
     if (covers.size() >= 4)
       break;
-
-    int trackId = track["id"].toInt();
-    QString coverPath = DatabaseManager::instance().getCoverPath(trackId);
-    if (!coverPath.isEmpty()) {
-      QPixmap pix(coverPath);
-      if (!pix.isNull()) {
-        covers.append(pix);
-      }
+    QPixmap pix = storedCover(coverId, 100); // A quarter of the composite
+    if (!pix.isNull()) {
+      covers.append(pix);
     }
   }
 
@@ -957,21 +1278,22 @@ void MainWindow::generateAlbumCoverGrid(int albumId, AlbumCard *card) {
   card->setCoverImage(composite);
 }
 
-void MainWindow::onTrackStreamUrl(const QString &url) {
+void MainWindow::onTrackStreamUrl(int trackId, const QString &url) {
   // Check if this is for downloading a favorite
-  if (currentTrackIdForStream != -1) {
-    int trackId = currentTrackIdForStream;
-    currentTrackIdForStream = -1; // Reset
-
+  if (pendingDownloadStreams.remove(trackId)) {
     statusLabel->setText("Downloading favorite track " +
                          QString::number(trackId) + "...");
     downloadManager->downloadTrack(url, trackId);
-    return;
   }
 
-  // Otherwise, play normally
+  // Play only if this is still the track the user asked for
+  if (trackId != pendingPlaybackTrackId)
+    return;
+  pendingPlaybackTrackId = -1;
+
   statusLabel->setText("Playing...");
   player->playUrl(url);
+  DatabaseManager::instance().recordPlayAsync(trackId);
   playPauseButton->setIcon(style()->standardIcon(QStyle::SP_MediaPause));
   // Show cover when playback starts
   if (!coverLabel->pixmap().isNull()) {
@@ -979,6 +1301,15 @@ void MainWindow::onTrackStreamUrl(const QString &url) {
   }
 }
 
+void MainWindow::updateStatusTip() {
+  QStringList parts;
+  for (const QString &part : {storageTip, networkTip}) {
+    if (!part.isEmpty())
+      parts.append(part);
+  }
+  statusLabel->setToolTip(parts.join("\n"));
+}
+
 void MainWindow::onPlayerError(const QString &message) {
   statusLabel->setText("Player Error: " + message);
 }
@@ -1028,150 +1359,191 @@ void MainWindow::onDurationChanged(qint64 duration) {
   seekSlider->setRange(0, duration);
 }
 
-void MainWindow::onCoverImageDownloaded(QNetworkReply *reply) {
-  // Check if this is for a favorite card (has User attribute with track ID)
-  if (reply->request().attribute(QNetworkRequest::User).isValid()) {
-    onFavoriteCoverDownloaded(reply);
-    return;
-  }
-
-  // Otherwise, it's for the playback cover
-  if (reply->error() == QNetworkReply::NoError) {
-    QByteArray data = reply->readAll();
-    QPixmap pixmap;
-
-    // Try loading with explicit format hint first
-    if (!pixmap.loadFromData(data, "JPG")) {
-      // Fallback to auto-detection
-      if (!pixmap.loadFromData(data)) {
-        qDebug() << "Failed to load pixmap from downloaded data";
-        // Do NOT hide the label here if we might have shown a local cover
-        // already! But wait, if we are here, it means we decided to download.
-        // If we decided to download, it means we didn't find a local cover.
-        // So it's safe to hide?
-        // EXCEPT if the race condition happened:
-        // 1. check local -> empty
-        // 2. start download
-        // 3. check local (in play block) -> found (maybe?) or found fallback
-        // 4. show cover
-        // 5. download finishes -> fails -> hides cover
-
-        // So, only hide if we don't have a valid pixmap on the label?
-        // Or just log error and don't hide.
-        // coverLabel->hide();
-        return;
-      }
-    }
-
-    coverLabel->setPixmap(pixmap.scaled(coverLabel->size(), Qt::KeepAspectRatio,
-                                        Qt::SmoothTransformation));
-    coverLabel->show();
-
-    // Save this cover!
-    // We should probably save it if we went through the trouble of downloading
-    // it But DownloadManager handles downloads usually. This is the old ad-hoc
-    // download. Let's leave it for now, but ensure we don't hide the label
-    // unnecessarily.
+int MainWindow::coverPixels(int size) const {
+  return qCeil(size * devicePixelRatioF());
+}
 
-  } else {
-    qDebug() << "Cover download error:" << reply->errorString();
-    // coverLabel->hide(); // Don't hide, might have local cover shown
-  }
-  reply->deleteLater();
+QPixmap MainWindow::storedCover(const QString &coverId, int size) const {
+  if (coverId.isEmpty())
+    return QPixmap();
+  QPixmap pixmap(
+      DatabaseManager::coverStorePath(coverId, coverPixels(size)));
+  if (pixmap.isNull())
+    pixmap.load(DatabaseManager::coverStorePath(coverId));
+  return pixmap;
 }
 
-void MainWindow::onFavoriteCoverDownloaded(QNetworkReply *reply) {
-  QVariant trackIdVar = reply->request().attribute(QNetworkRequest::User);
-  if (!trackIdVar.isValid()) {
-    qDebug() << "Favorite cover download has no track ID";
-    reply->deleteLater();
-    return;
+void MainWindow::onCoverStored(const QString &coverId, int pixels,
+                               const QString &coverPath,
+                               const QImage &image, bool stored) {
+  // A cover read back from the store is recorded already
+  if (stored) {
+    DatabaseManager::instance().write([coverId, coverPath]() {
+      DatabaseManager::instance().storeCover(coverId, coverPath);
+    });
+    storageManager->scheduleCompaction();
   }
-
-  int trackId = trackIdVar.toInt();
-
-  if (reply->error() != QNetworkReply::NoError) {
-    qDebug() << "Network error for favorite track" << trackId << ":"
-             << reply->errorString();
-    reply->deleteLater();
+  if (image.isNull()) {
+    // Leave the label alone: a local cover may already be showing
+    qDebug() << "Could not decode stored cover" << coverPath;
     return;
   }
 
-  QByteArray data = reply->readAll();
-  qDebug() << "Downloaded" << data.size() << "bytes for track" << trackId;
-  if (data.size() > 0) {
-    qDebug() << "First 20 bytes:" << data.left(20).toHex();
-  }
+  // Decoded and sized on the I/O thread; shown without further scaling
+  QPixmap pixmap = QPixmap::fromImage(image);
+  pixmap.setDevicePixelRatio(devicePixelRatioF());
 
-  QPixmap pixmap;
-  // Try loading with explicit format since loadFromData might fail on some
-  // images
-  if (!pixmap.loadFromData(data, "JPG")) {
-    qDebug() << "Failed to load as JPG, trying default format for track"
-             << trackId;
-    if (!pixmap.loadFromData(data)) {
-      qDebug() << "Failed to load pixmap with any format for track" << trackId;
-      reply->deleteLater();
-      return;
+  // One download serves every card of the album
+  if (pixels == coverPixels(FavoriteCard::coverSize)) {
+    for (auto *card : favoriteCards) {
+      if (card->getTrack().cover() == coverId)
+        card->setCoverImage(pixmap);
     }
   }
 
-  // Find the card for this track
-  for (auto *card : favoriteCards) {
-    if (card->getTrackId() == trackId) {
-      card->setCoverImage(pixmap);
-      qDebug() << "Set cover image for track" << trackId;
-      break;
-    }
-  }
+  if (coverId != pendingCoverId || pixels != coverPixels(coverLabel->width()))
+    return; // Another track's cover was requested since
+  pendingCoverId.clear();
+  coverLabel->setPixmap(pixmap);
+  coverLabel->show();
+}
 
-  reply->deleteLater();
+void MainWindow::onAlbumLoaded(const Album &album,
+                               const QList<Track> &tracks) {
+  qDebug() << "Album loaded:" << album.title << "with" << tracks.size()
+           << "tracks";
+  if (!pendingOfflineAlbums.remove(album.id))
+    return;
+
+  // Kept as a user album so the tracks have rows and can be played offline;
+  // one saved before is filled again rather than copied
+  DatabaseManager::instance()
+      .write([album, tracks]() {
+        DatabaseManager &db = DatabaseManager::instance();
+        int albumId = db.getAlbumBySource(album.id);
+        if (albumId < 0)
+          albumId = db.createAlbum(album.title, QString(), album.id);
+        return albumId >= 0 && db.addTracksToAlbum(albumId, tracks);
+      })
+      .then(this, [this, album, tracks](bool saved) {
+        if (!saved) {
+          statusLabel->setText("Could not save album " + album.title);
+          return;
+        }
+        refreshAlbumsList();
+        offlineSync->syncTracks(tracks, coverPixels(FavoriteCard::coverSize));
+      });
 }
 
-void MainWindow::onAlbumLoaded(const QJsonObject &album) {
-  // Placeholder for album handling
-  qDebug() << "Album loaded:" << album;
+void MainWindow::onAlbumOfflineClicked(int albumId) {
+  DatabaseManager::instance().getAlbumTracksAsync(albumId).then(
+      this, [this](const QList<Track> &tracks) {
+        statusLabel->setText(QString("Making %1 tracks available offline...")
+                                 .arg(tracks.size()));
+        offlineSync->syncTracks(tracks, coverPixels(FavoriteCard::coverSize));
+      });
 }
 
-void MainWindow::onFavoriteToggled(const QJsonObject &track, bool isFavorite) {
-  int trackId = track["id"].toInt();
+void MainWindow::onFavoriteToggled(const Track &track, bool isFavorite) {
+  int trackId = track.id();
 
   if (isFavorite) {
-    if (DatabaseManager::instance().addFavorite(track)) {
-      // Start download if not already downloaded
-      QString localPath = DatabaseManager::instance().getFilePath(trackId);
-      if (localPath.isEmpty() || !QFile::exists(localPath)) {
-        statusLabel->setText("Fetching stream URL to download favorite...");
-        // Set the trackId for the stream URL handler to know it's for
-        // download
-        currentTrackIdForStream = trackId;
-        hifiClient->getTrackStream(trackId);
-      } else {
-        statusLabel->setText("Track already downloaded.");
-      }
-    } else {
-      // This else block means addFavorite failed, which shouldn't happen if
-      // track is valid. If it means "if not isFavorite", then the logic is
-      // inverted. Assuming the original intent was: if isFavorite, add it. If
-      // not, remove it. The original code had an issue here. Correcting based
-      // on common pattern.
-      qDebug() << "Failed to add favorite track" << trackId;
-    }
+    // Stored on the DB thread, which also looks for a downloaded file
+    DatabaseManager::instance()
+        .write([track]() {
+          DatabaseManager &db = DatabaseManager::instance();
+          bool added = db.addFavorite(track);
+          QString localPath = db.getFilePath(track.id());
+          return qMakePair(added,
+                           !localPath.isEmpty() && QFile::exists(localPath));
+        })
+        .then(this, [this, trackId](QPair<bool, bool> result) {
+          auto [added, downloaded] = result;
+          if (!added) {
+            qDebug() << "Failed to add favorite track" << trackId;
+          } else if (!downloaded) {
+            statusLabel->setText(
+                "Fetching stream URL to download favorite...");
+            // Mark the trackId so the stream URL handler also downloads it
+            pendingDownloadStreams.insert(trackId);
+            hifiClient->getTrackStream(trackId);
+          } else {
+            statusLabel->setText("Track already downloaded.");
+          }
+          refreshFavoritesList();
+        });
   } else { // if not isFavorite
-    DatabaseManager::instance().removeFavorite(trackId);
-    // Optional: delete file
-    QString localPath = DatabaseManager::instance().getFilePath(trackId);
-    if (!localPath.isEmpty() && QFile::exists(localPath)) {
-      QFile::remove(localPath);
-      DatabaseManager::instance().updateFilePath(trackId,
-                                                 ""); // Clear path in DB
-    }
+    pendingDownloadStreams.remove(trackId);
+    downloadManager->cancelTrack(trackId);
+    offlineSync->cancelTrack(trackId);
+    // Unfavorite and delete the file on the DB thread
+    DatabaseManager::instance()
+        .write([trackId]() {
+          DatabaseManager &db = DatabaseManager::instance();
+          db.removeFavorite(trackId);
+          QString localPath = db.getFilePath(trackId);
+          if (!localPath.isEmpty() && QFile::exists(localPath)) {
+            QFile::remove(localPath);
+            db.updateFilePath(trackId, ""); // Clear path in DB
+          }
+        })
+        .then(this, [this]() { refreshFavoritesList(); });
+    storageManager->scheduleCompaction(); // Prunes its cover
   }
-
-  refreshFavoritesList();
 }
 
+// Six columns of cards; a page fills several rows
+static const int favoritesPageSize = 48;
+
 void MainWindow::refreshFavoritesList() {
+  // Read off the GUI thread; only the newest request fills the grid. The
+  // first page comes with every id, so playback can go past the cards
+  // loaded so far.
+  int generation = ++favoritesGeneration;
+  favoritesPageLoading = true;
+  DatabaseManager::instance()
+      .read([]() {
+        DatabaseManager &db = DatabaseManager::instance();
+        return qMakePair(db.fetchFavorites(TrackCursor(), favoritesPageSize),
+                         db.getFavoriteIds());
+      })
+      .then(this, [this, generation](
+                      const QPair<TrackPage, QList<int>> &first) {
+        if (generation != favoritesGeneration)
+          return;
+        favoritesPageLoading = false;
+        favoritesCursor = first.first.next;
+        favoriteQueue = first.second;
+        showFavorites(first.first.tracks);
+        fetchNextFavoritesPage();
+      });
+}
+
+void MainWindow::fetchNextFavoritesPage() {
+  if (favoritesPageLoading || favoritesCursor.atEnd ||
+      pageStack->currentWidget() != homePage)
+    return;
+
+  // Prefetch once the user is within a screen of the end
+  QScrollBar *bar = favouritesScrollArea->verticalScrollBar();
+  if (bar->maximum() - bar->value() > bar->pageStep())
+    return;
+
+  favoritesPageLoading = true;
+  int generation = favoritesGeneration;
+  DatabaseManager::instance()
+      .fetchFavoritesAsync(favoritesCursor, favoritesPageSize)
+      .then(this, [this, generation](const TrackPage &page) {
+        if (generation != favoritesGeneration)
+          return; // The grid was refilled meanwhile
+        favoritesPageLoading = false;
+        favoritesCursor = page.next;
+        appendFavorites(page.tracks);
+        fetchNextFavoritesPage();
+      });
+}
+
+void MainWindow::showFavorites(const QList<Track> &favs) {
   // Clear existing items
   QLayoutItem *item;
   while ((item = favouritesGrid->takeAt(0)) != nullptr) {
@@ -1180,8 +1552,6 @@ void MainWindow::refreshFavoritesList() {
   }
   favoriteCards.clear();
 
-  auto favs = DatabaseManager::instance().getFavorites();
-
   if (favs.isEmpty()) {
     QLabel *emptyLabel = new QLabel("No favorites yet", this);
     emptyLabel->setStyleSheet("color: #b3b3b3; font-size: 14px;");
@@ -1189,29 +1559,32 @@ void MainWindow::refreshFavoritesList() {
     favouritesGrid->addWidget(emptyLabel, 0, 0);
     return;
   }
+  appendFavorites(favs);
+}
 
-  int row = 0;
-  int col = 0;
+void MainWindow::appendFavorites(const QList<Track> &favs) {
   int maxCols = 6; // Adjusted for 120px cards
+  // Cards only; the grid holds nothing else once it has favorites
+  int row = favouritesGrid->count() / maxCols;
+  int col = favouritesGrid->count() % maxCols;
 
-  for (const auto &track : favs) {
-    int id = track["id"].toInt();
+  for (const Track &track : favs) {
+    int id = track.id();
     trackCache.insert(id, track);
 
     FavoriteCard *card = new FavoriteCard(track);
     connect(card, &FavoriteCard::clicked, this, [this, id]() {
       // Populate playlist with all favorites
-      currentPlaylist.clear();
-      auto favs = DatabaseManager::instance().getFavorites();
-      for (const auto &f : favs)
-        currentPlaylist.append(f["id"].toInt());
-
+      currentPlaylist = favoriteQueue;
       currentTrackIndex = currentPlaylist.indexOf(id);
       onFavoriteCardClicked(id);
     });
     connect(card, &FavoriteCard::unfavoriteClicked, this, [this, id]() {
-      DatabaseManager::instance().removeFavorite(id);
-      refreshFavoritesList();
+      downloadManager->cancelTrack(id);
+      offlineSync->cancelTrack(id);
+      DatabaseManager::instance().removeFavoriteAsync(id).then(
+          this, [this](bool) { refreshFavoritesList(); });
+      storageManager->scheduleCompaction(); // Prunes its cover
     });
     connect(card, &FavoriteCard::artistClicked, this,
             &MainWindow::onArtistClicked);
@@ -1219,31 +1592,15 @@ void MainWindow::refreshFavoritesList() {
     favouritesGrid->addWidget(card, row, col);
     favoriteCards.append(card);
 
-    // Check if we have a local cover first
-    QString localCoverPath = track["coverPath"].toString();
-    if (!localCoverPath.isEmpty() && QFile::exists(localCoverPath)) {
-      QPixmap pixmap(localCoverPath);
-      if (!pixmap.isNull()) {
+    // Thumbnail at the card's size: from the store, else made or fetched
+    QString coverId = track.cover();
+    if (!coverId.isEmpty()) {
+      int pixels = coverPixels(FavoriteCard::coverSize);
+      QPixmap pixmap(DatabaseManager::coverStorePath(coverId, pixels));
+      if (!pixmap.isNull())
         card->setCoverImage(pixmap);
-      } else {
-        // If local file is bad, try downloading again
-        QString coverId = track["album"].toObject()["cover"].toString();
-        if (!coverId.isEmpty()) {
-          QString coverUrl =
-              QString("https://resources.tidal.com/images/%1/640x640.jpg")
-                  .arg(coverId.replace("-", "/"));
-          downloadManager->downloadCover(coverUrl, id);
-        }
-      }
-    } else {
-      // No local cover, try downloading
-      QString coverId = track["album"].toObject()["cover"].toString();
-      if (!coverId.isEmpty()) {
-        QString coverUrl =
-            QString("https://resources.tidal.com/images/%1/640x640.jpg")
-                .arg(coverId.replace("-", "/"));
-        downloadManager->downloadCover(coverUrl, id);
-      }
+      else
+        downloadManager->downloadCover(coverId, pixels);
     }
 
     col++;
@@ -1255,7 +1612,12 @@ void MainWindow::refreshFavoritesList() {
 }
 
 void MainWindow::onDownloadFinished(int trackId, const QString &filePath) {
-  DatabaseManager::instance().updateFilePath(trackId, filePath);
+  // Tracks of an offline sync are recorded in its batches
+  if (!offlineSync->isSyncing(trackId))
+    DatabaseManager::instance().write([trackId, filePath]() {
+      DatabaseManager::instance().updateFilePath(trackId, filePath);
+    });
+  storageManager->scheduleCompaction();
   statusLabel->setText("Download complete for track " +
                        QString::number(trackId));
 }
@@ -1266,27 +1628,40 @@ void MainWindow::onHomeClicked() {
 }
 
 void MainWindow::onFavoriteCardClicked(int trackId) {
-  // Update player info
   currentTrackId = trackId;
-  QJsonObject track;
+  // The row has the metadata and the downloaded file; read it off the GUI
+  // thread, since a cached track may predate its download
+  int generation = ++playbackGeneration;
+  DatabaseManager::instance()
+      .read([trackId]() {
+        Track track = DatabaseManager::instance().getTrack(trackId);
+        if (!QFile::exists(track.filePath()))
+          track.setFilePath(QString());
+        return track;
+      })
+      .then(this, [this, trackId, generation](const Track &stored) {
+        if (generation == playbackGeneration)
+          playStoredTrack(trackId, stored);
+      });
+}
 
+void MainWindow::playStoredTrack(int trackId, const Track &stored) {
+  // Update player info
+  Track track;
   if (trackCache.contains(trackId)) {
     track = trackCache[trackId];
+  } else if (!stored.isNull()) {
+    // Add to cache for future use
+    track = stored;
+    trackCache.insert(trackId, track);
   } else {
-    // Track not in cache, fetch from database
-    track = DatabaseManager::instance().getTrack(trackId);
-    if (!track.isEmpty()) {
-      // Add to cache for future use
-      trackCache.insert(trackId, track);
-    } else {
-      statusLabel->setText("Error: Favorite track not found in database.");
-      coverLabel->hide();
-      return;
-    }
+    statusLabel->setText("Error: Favorite track not found in database.");
+    coverLabel->hide();
+    return;
   }
 
-  QString title = track["title"].toString();
-  QString artist = track["artist"].toObject()["name"].toString();
+  QString title = track.title();
+  QString artist = track.artistName();
 
   playerTitleLabel->setText(title);
   playerArtistLabel->setText(artist);
@@ -1295,101 +1670,36 @@ void MainWindow::onFavoriteCardClicked(int trackId) {
 
   statusLabel->setText("Playing: " + title + " by " + artist);
 
-  if (track.contains("album")) {
-    // Check for local cover first
-    QString localCoverPath = DatabaseManager::instance().getCoverPath(trackId);
-
-    if (localCoverPath.isEmpty()) {
-      QString appData =
-          QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-      QString standardPath =
-          appData + "/covers/" + QString::number(trackId) + ".jpg";
-      if (QFile::exists(standardPath)) {
-        localCoverPath = standardPath;
-        // Optionally update DB here?
-        DatabaseManager::instance().updateCoverPath(trackId, standardPath);
-      }
-    }
-
-    if (!localCoverPath.isEmpty() && QFile::exists(localCoverPath)) {
-      // running locally, no fetch brother
-      qDebug() << "Cover available locally at" << localCoverPath
-               << "- skipping network fetch";
-    } else {
-      qDebug() << "Cover NOT found locally for" << trackId
-               << "- fetching from network";
-      QJsonObject album = track["album"].toObject();
-      if (album.contains("cover")) {
-        QString coverId = album["cover"].toString();
-        if (!coverId.isEmpty()) {
-          QString coverUrl =
-              QString("https://resources.tidal.com/images/%1/640x640.jpg")
-                  .arg(coverId.replace("-", "/"));
-
-          QNetworkRequest request{QUrl(coverUrl)};
-          QNetworkReply *reply = imageManager->get(request);
-
-          connect(reply, &QNetworkReply::finished, this,
-                  [this, reply]() { onCoverImageDownloaded(reply); });
-        } else {
-          qDebug() << "Favorite track" << trackId
-                   << "album has empty cover ID.";
-          coverLabel->hide();
-        }
-      } else {
-        qDebug() << "Favorite track" << trackId
-                 << "album has no 'cover' field.";
-        coverLabel->hide();
-      }
-    }
+  // Cover at the label's size; the store answers from disk when it can
+  QString coverId = track.cover();
+  if (!coverId.isEmpty()) {
+    pendingCoverId = coverId;
+    downloadManager->downloadCover(coverId, coverPixels(coverLabel->width()),
+                                   TransferScheduler::Interactive);
   } else {
-    qDebug() << "Favorite track" << trackId << "has no 'album' field.";
+    qDebug() << "Favorite track" << trackId << "album has empty cover ID.";
     coverLabel->hide();
   }
 
   // Check if we have the file locally for this track
-  QString localPath = DatabaseManager::instance().getFilePath(trackId);
+  QString localPath = stored.filePath();
   qDebug() << "Playing favorite track" << trackId;
   qDebug() << "Database file path:" << localPath;
-  qDebug() << "File exists:" << QFile::exists(localPath);
 
-  if (!localPath.isEmpty() && QFile::exists(localPath)) {
+  if (!localPath.isEmpty()) {
     statusLabel->setText("Playing from local cache...");
     qDebug() << "Playing from local file:" << localPath;
+    pendingPlaybackTrackId = -1;
     player->playUrl(QUrl::fromLocalFile(localPath).toString());
+    DatabaseManager::instance().recordPlayAsync(trackId);
     playPauseButton->setIcon(style()->standardIcon(QStyle::SP_MediaPause));
-    // Show cover
-    QString coverPath = DatabaseManager::instance().getCoverPath(trackId);
-    if (!coverPath.isEmpty() && QFile::exists(coverPath)) {
-      QPixmap pixmap(coverPath);
-      if (!pixmap.isNull()) {
-        coverLabel->setPixmap(pixmap.scaled(
-            coverLabel->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation));
-        coverLabel->show();
-        playerTitleLabel->show();
-        playerArtistLabel->show();
-      }
-    } else {
-      // Try standard location as fallback
-      QString appData =
-          QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-      QString potentialCover =
-          appData + "/covers/" + QString::number(trackId) + ".jpg";
-      if (QFile::exists(potentialCover)) {
-        QPixmap pixmap(potentialCover);
-        if (!pixmap.isNull()) {
-          coverLabel->setPixmap(pixmap.scaled(coverLabel->size(),
-                                              Qt::KeepAspectRatio,
-                                              Qt::SmoothTransformation));
-          coverLabel->show();
-          playerTitleLabel->show();
-          playerArtistLabel->show();
-        }
-      }
-    }
+    // The cover arrives through onCoverStored
   } else {
     qDebug() << "File not available locally, fetching stream...";
+    pendingPlaybackTrackId = trackId;
     hifiClient->getTrackStream(trackId);
+    // Move a queued download of this favorite ahead of background sync
+    downloadManager->prioritizeTrack(trackId, TransferScheduler::Prefetch);
   }
 }
 
@@ -1441,9 +1751,9 @@ void MainWindow::onArtistClicked(int artistId, const QString &artistName) {
   currentArtistId = artistId;
 
   // Clear previous artist data
-  artistPage->setArtistData(QJsonObject());
-  artistPage->setTopTracks(QJsonArray());
-  artistPage->setAlbums(QJsonArray());
+  artistPage->setArtistData(Artist());
+  artistPage->setTopTracks(QList<Track>());
+  artistPage->setAlbums(QList<Album>());
 
   // Navigate to artist page
   pageStack->setCurrentIndex(3);
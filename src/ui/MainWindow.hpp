@@ -9,16 +9,21 @@
 #include <QListWidget>
 #include <QMainWindow>
 #include <QMessageBox>
-#include <QNetworkReply>
+#include <QImage>
+#include <QPixmap>
 #include <QPushButton>
 #include <QScrollArea>
+#include <QSet>
 #include <QSlider>
 #include <QStackedWidget>
+#include <QTimer>
 #include <QVBoxLayout>
 
 #include "../api/HifiClient.hpp"
 #include "../db/DatabaseManager.hpp"
+#include "../db/StorageManager.hpp"
 #include "../net/DownloadManager.hpp"
+#include "../net/OfflineSync.hpp"
 #include "../player/AudioPlayer.hpp"
 #include "AlbumCard.hpp"
 #include "ArtistProfilePage.hpp"
@@ -33,34 +38,42 @@ public:
 
 private slots:
   void onSearchClicked();
+  void onSearchTextEdited(const QString &text);
   void onTrackSelected(QListWidgetItem *item);
-  void onTrackStreamUrl(const QString &url);
+  void onTrackStreamUrl(int trackId, const QString &url);
   void onPlayerError(const QString &message);
   void onApiError(const QString &message);
   void onPlayPauseClicked();
-  void onAlbumLoaded(const QJsonObject &album);
+  void onAlbumLoaded(const Album &album, const QList<Track> &tracks);
   void onVolumeChanged(int volume);
   void onSeekSliderMoved(int position);
   void onSeekSliderPressed();
   void onSeekSliderReleased();
   void onPositionChanged(qint64 position);
   void onDurationChanged(qint64 duration);
-  void onCoverImageDownloaded(QNetworkReply *reply);
-  void onFavoriteToggled(const QJsonObject &track, bool isFavorite);
+  void onCoverStored(const QString &coverId, int pixels,
+                     const QString &coverPath, const QImage &image,
+                     bool stored);
+  void onFavoriteToggled(const Track &track, bool isFavorite);
   void onDownloadFinished(int trackId, const QString &filePath);
   void onHomeClicked();
   void onFavoriteCardClicked(int trackId);
-  void onFavoriteCoverDownloaded(QNetworkReply *reply);
   void onAddAlbumClicked();
   void onAlbumCardClicked(int albumId);
-  void onAddToAlbumClicked(const QJsonObject &track);
+  void onAddToAlbumClicked(const Track &track);
   void onAlbumDeleteClicked(int albumId);
+  void onAlbumOfflineClicked(int albumId);
   void onNextClicked();
   void onPrevClicked();
   void onArtistClicked(int artistId, const QString &artistName);
 
 private:
-  void generateAlbumCoverGrid(int albumId, AlbumCard *card);
+  void generateAlbumCoverGrid(const QStringList &coverIds, AlbumCard *card);
+  // Device pixels of a square cover shown at size logical pixels
+  int coverPixels(int size) const;
+  // The stored thumbnail for size logical pixels, else the stored original;
+  // null if neither is on disk
+  QPixmap storedCover(const QString &coverId, int size) const;
 
   HifiClient *hifiClient;
   AudioPlayer *player;
@@ -70,19 +83,46 @@ private:
   QPushButton *searchButton;
   QListWidget *resultsList;
 
+  // Search-as-you-type: requests wait for a pause in typing, and the last
+  // results are filtered locally while a longer query is in flight.
+  QTimer *searchDebounce;
+  QString searchInFlightQuery;
+  QString cachedResultsQuery;
+  QList<Track> cachedResults;
+  QList<Track> filterCachedResults(const QString &query) const;
+  void showSearchResults(const QList<Track> &tracks);
+
+  // Results arrive a page at a time as the list nears its end, and rows are
+  // built in batches between event loop iterations.
+  int searchTotal = 0; // Size of the whole result set for cachedResultsQuery
+  bool searchPageLoading = false;
+  bool resultBatchScheduled = false;
+  QList<Track> pendingResultRows; // Parsed, not yet given a row widget
+  void appendSearchResults(const QList<Track> &tracks);
+  void renderResultBatch();
+  void addResultRow(const Track &track);
+  void fetchNextResultPage();
+
   QPushButton *playPauseButton;
   QSlider *volumeSlider;
   QSlider *seekSlider;
   QLabel *statusLabel;
+  // The status bar tooltip: storage usage, then request and mirror health
+  QString storageTip;
+  QString networkTip;
+  void updateStatusTip();
   QLabel *coverLabel;
   QLabel *playerTitleLabel;
   QPushButton *playerArtistLabel;
 
-  QNetworkAccessManager *imageManager;
+  QString pendingCoverId; // Playback cover being fetched
   bool isSeeking = false;
 
-  QMap<int, QJsonObject> trackCache; // Cache tracks by ID
-  int currentTrackIdForStream = -1;
+  QHash<int, Track> trackCache; // Cache tracks by ID
+  // Stream URL consumers: a resolved URL may feed a download, playback or both
+  QSet<int> pendingDownloadStreams;
+  int pendingPlaybackTrackId = -1;
+  QSet<int> pendingOfflineAlbums; // Tidal albums to sync once loaded
   int currentTrackId = -1;
 
   // Navigation context
@@ -90,9 +130,31 @@ private:
   int currentTrackIndex = -1;
 
   DownloadManager *downloadManager;
+  StorageManager *storageManager;
+  OfflineSync *offlineSync;
 
   void refreshFavoritesList();
   void refreshAlbumsList();
+  // Fill the home grid and the album view from rows read off the GUI thread
+  void showFavorites(const QList<Track> &favs);
+  void appendFavorites(const QList<Track> &favs);
+  // Reads the next page of favorites once the grid is scrolled near its end
+  void fetchNextFavoritesPage();
+  TrackCursor favoritesCursor; // After the last card in the grid
+  bool favoritesPageLoading = false;
+  QList<int> favoriteQueue; // Every favorite in grid order, for playback
+  void showAlbumTracks(const QList<Track> &tracks);
+  void showAlbums(const QList<Album> &albums,
+                  const QHash<int, QStringList> &trackCovers);
+  // Asks which album gets the track, once the albums have been read
+  void chooseAlbumFor(const Track &track, const QList<Album> &albums);
+  // Plays a favorite or album track once its row has been read; a row with
+  // a file path plays from disk
+  void playStoredTrack(int trackId, const Track &stored);
+  int favoritesGeneration = 0;  // Newest favorites read
+  int albumTracksGeneration = 0; // Newest album view read
+  int albumsGeneration = 0;      // Newest album row read
+  int playbackGeneration = 0;    // Newest local file lookup
 
   // Page navigation
   QStackedWidget *pageStack;
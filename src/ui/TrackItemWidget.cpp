@@ -2,15 +2,15 @@
 #include <QDebug>
 #include <QStyle>
 
-TrackItemWidget::TrackItemWidget(const QJsonObject &trackData, bool isFavorite,
+TrackItemWidget::TrackItemWidget(const Track &track, bool isFavorite,
                                  QWidget *parent)
-    : QWidget(parent), m_trackData(trackData), m_isFavorite(isFavorite) {
+    : QWidget(parent), m_track(track), m_isFavorite(isFavorite) {
 
   QHBoxLayout *layout = new QHBoxLayout(this);
   layout->setContentsMargins(5, 5, 5, 5);
 
-  QString title = trackData["title"].toString();
-  QString artist = trackData["artist"].toObject()["name"].toString();
+  QString title = track.title();
+  QString artist = track.artistName();
 
   titleLabel = new QLabel(title, this);
   titleLabel->setStyleSheet("font-weight: bold; font-size: 14px;");
@@ -32,8 +32,7 @@ TrackItemWidget::TrackItemWidget(const QJsonObject &trackData, bool isFavorite,
                              "}");
 
   // Extract artist ID and connect signal
-  QJsonObject artistObj = trackData["artist"].toObject();
-  int artistId = artistObj["id"].toInt();
+  int artistId = track.artistId();
   qDebug() << "TrackItemWidget: Artist" << artist << "ID:" << artistId;
 
   connect(artistLabel, &QPushButton::clicked, this, [this, artistId, artist]() {
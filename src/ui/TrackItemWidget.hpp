@@ -1,8 +1,8 @@
 #pragma once
 
 #include <QEvent>
+#include "../model/Track.hpp"
 #include <QHBoxLayout>
-#include <QJsonObject>
 #include <QLabel>
 #include <QPushButton>
 #include <QWidget>
@@ -11,12 +11,12 @@ class TrackItemWidget : public QWidget {
   Q_OBJECT
 
 public:
-  explicit TrackItemWidget(const QJsonObject &trackData, bool isFavorite,
+  explicit TrackItemWidget(const Track &track, bool isFavorite,
                            QWidget *parent = nullptr);
 
   void setFavorite(bool favorite);
   bool isFavorite() const { return m_isFavorite; }
-  QJsonObject getTrackData() const { return m_trackData; }
+  Track getTrack() const { return m_track; }
 
 signals:
   void favoriteToggled(bool isFavorite);
@@ -28,7 +28,7 @@ protected:
   void leaveEvent(QEvent *event) override;
 
 private:
-  QJsonObject m_trackData;
+  Track m_track;
   bool m_isFavorite;
 
   QLabel *titleLabel;